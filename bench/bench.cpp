@@ -0,0 +1,699 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+	Micro-benchmarks of the solver kernels.
+
+	Each kernel is timed separately on synthetic and/or real instances, and
+	reported in nanoseconds per operation. When the hardware counters are
+	available (Linux perf events), cache misses and data TLB misses per
+	operation are reported too, for instance to compare the pages of the
+	large arrays (see --huge-pages). Results can be saved and compared
+	against a saved baseline.
+*/
+
+#include "scp_problem.hpp"
+#include "scp_index.hpp"
+#include "scp_grasp.hpp"
+#include "scp_local_search.hpp"
+#include "scp_repair.hpp"
+#include "scp_score.hpp"
+#include "scp_memory.hpp"
+#include "scp_renumber.hpp"
+#include "chrono.hpp"
+#include "gzfstream.hpp"
+#include "docopt.hpp"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+/*
+	Class: bench_counter
+
+	Hardware cache miss or data TLB load miss counter of the calling thread
+	(Linux only).
+*/
+struct bench_counter
+{
+	enum event_type
+	{
+		cache_misses,
+		tlb_misses
+	};
+
+	bench_counter( event_type e = cache_misses );
+	~bench_counter();
+
+	bool ok() const;
+	void start();
+	double stop();
+
+private:
+	int _fd;
+};
+
+inline bench_counter::bench_counter( event_type e ) :
+	_fd( -1 )
+{
+#ifdef __linux__
+	perf_event_attr attr;
+
+	std::memset( &attr, 0, sizeof( attr ) );
+	attr.size = sizeof( attr );
+	if ( e == tlb_misses )
+	{
+		attr.type = PERF_TYPE_HW_CACHE;
+		attr.config = PERF_COUNT_HW_CACHE_DTLB
+		            | ( PERF_COUNT_HW_CACHE_OP_READ << 8 )
+		            | ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 );
+	}
+	else
+	{
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_CACHE_MISSES;
+	}
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	_fd = syscall( __NR_perf_event_open, &attr, 0, -1, -1, 0 );
+#endif
+}
+
+inline bench_counter::~bench_counter()
+{
+	if ( _fd >= 0 )
+	{
+		close( _fd );
+	}
+}
+
+inline bool bench_counter::ok() const
+{
+	return _fd >= 0;
+}
+
+inline void bench_counter::start()
+{
+#ifdef __linux__
+	if ( _fd >= 0 )
+	{
+		ioctl( _fd, PERF_EVENT_IOC_RESET, 0 );
+		ioctl( _fd, PERF_EVENT_IOC_ENABLE, 0 );
+	}
+#endif
+}
+
+inline double bench_counter::stop()
+{
+	uint64_t count = 0;
+#ifdef __linux__
+	if ( _fd >= 0 )
+	{
+		ioctl( _fd, PERF_EVENT_IOC_DISABLE, 0 );
+
+		if ( read( _fd, &count, sizeof( count ) ) != sizeof( count ) )
+		{
+			count = 0;
+		}
+	}
+#endif
+	return double( count );
+}
+
+/*
+	Class: bench_kernel
+
+	A benchmarked kernel. <setup> is not timed and is called before each
+	<run>, which returns the number of operations performed.
+*/
+struct bench_kernel
+{
+	virtual ~bench_kernel() {}
+	virtual std::string name() const = 0;
+	virtual void setup() {}
+	virtual int run() = 0;
+};
+
+/*
+	Class: scp_bench
+
+	Access to the solver internals for the kernels that are not part of
+	the public interface.
+*/
+struct scp_bench
+{
+	static void reset( scp_grasp & grasp );
+	static int add( scp_grasp & grasp, int i );
+};
+
+inline void scp_bench::reset( scp_grasp & grasp )
+{
+	grasp._reset();
+	grasp._x.clear();
+}
+
+inline int scp_bench::add( scp_grasp & grasp, int i )
+{
+	return grasp._add( i );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+	Class: bench_data
+
+	An instance, the solvers loaded with it and a pool of GRASP solutions
+	used as inputs of the kernels.
+*/
+struct bench_data
+{
+	bench_data( const std::string & n, double alpha, int pool_size );
+
+	std::string name;
+	scp_problem instance;
+	scp_index index;
+	scp_grasp grasp;
+	scp_local_search local_search;
+	scp_repair repair;
+	std::vector<scp_solution> pool;
+
+	bool init();
+	const scp_solution & next();
+
+private:
+	int _pool_size, _next;
+};
+
+inline bench_data::bench_data( const std::string & n, double alpha, int pool_size ) :
+	name( n ), grasp( alpha ), _pool_size( pool_size ), _next( 0 )
+{
+}
+
+inline bool bench_data::init()
+{
+	index.build( instance );
+	grasp.read( instance, index );
+	local_search.read( instance, index );
+	repair.read( instance, index );
+
+	pool.clear();
+
+	for ( int k = 0; k < _pool_size; ++k )
+	{
+		if ( !grasp.run() )
+		{
+			return false;
+		}
+		pool.push_back( grasp.x() );
+	}
+	return true;
+}
+
+inline const scp_solution & bench_data::next()
+{
+	const scp_solution & x = pool[_next];
+	_next = ( _next + 1 ) % pool.size();
+	return x;
+}
+
+struct bench_grasp_run : bench_kernel
+{
+	bench_grasp_run( bench_data & d ) : data( d ) {}
+	std::string name() const { return "grasp::run"; }
+	int run() { data.grasp.run(); return 1; }
+	bench_data & data;
+};
+
+struct bench_grasp_add : bench_kernel
+{
+	bench_grasp_add( bench_data & d ) : data( d ) {}
+	std::string name() const { return "grasp::_add"; }
+	void setup()
+	{
+		x = data.next();
+		scp_bench::reset( data.grasp );
+	}
+	int run()
+	{
+		scp_solution::const_iterator it;
+
+		for ( it = x.begin(); it != x.end(); ++it )
+		{
+			scp_bench::add( data.grasp, *it );
+		}
+		return x.size();
+	}
+	bench_data & data;
+	scp_solution x;
+};
+
+struct bench_local_search : bench_kernel
+{
+	bench_local_search( bench_data & d, int e, const std::string & n ) :
+		data( d ), exchanges( e ), label( n ) {}
+	std::string name() const { return label; }
+	void setup() { data.local_search.read( data.next() ); }
+	int run() { data.local_search.run( exchanges ); return 1; }
+	bench_data & data;
+	int exchanges;
+	std::string label;
+};
+
+struct bench_repair : bench_kernel
+{
+	bench_repair( bench_data & d ) : data( d ) {}
+	std::string name() const { return "repair::run"; }
+	void setup()
+	{
+		// Drop every other column of a feasible solution
+		const scp_solution & x = data.next();
+		scp_solution::const_iterator it;
+		bool keep = true;
+
+		y.resize( x.num_elements() );
+		for ( it = x.begin(); it != x.end(); ++it, keep = !keep )
+		{
+			if ( keep ) y.insert( *it );
+		}
+		data.repair.read( y );
+	}
+	int run() { data.repair.run(); return 1; }
+	bench_data & data;
+	scp_solution y;
+};
+
+struct bench_index_build : bench_kernel
+{
+	bench_index_build( bench_data & d ) : data( d ) {}
+	std::string name() const { return "index::build"; }
+	int run() { index.build( data.instance ); return 1; }
+	bench_data & data;
+	scp_index index;
+};
+
+// One scan of the greedy scoring on the initial uncovered counts, per column
+struct bench_score : bench_kernel
+{
+	bench_score( bench_data & d, scp_score::isa_type i ) : data( d ), isa( i ) {}
+	std::string name() const { return std::string( "score::scan/" ) + scp_score::name( isa ); }
+	void setup()
+	{
+		int m = data.index.num_elements();
+
+		score.isa( isa );
+		score.read( data.instance.c );
+		u.resize( m );
+
+		for ( int i = 0; i < m; ++i )
+		{
+			u[i] = data.index.T_size( i );
+		}
+	}
+	int run()
+	{
+		double e_min, e_max;
+
+		score.minmax( u, e_min, e_max );
+		score.select( u, e_min + data.grasp.alpha * ( e_max - e_min ), rcl );
+		return u.size();
+	}
+	bench_data & data;
+	scp_score::isa_type isa;
+	scp_score score;
+	std::vector<int> u, rcl;
+};
+
+struct bench_check : bench_kernel
+{
+	bench_check( bench_data & d ) : data( d ) {}
+	std::string name() const { return "problem::check"; }
+	int run() { data.instance.check( data.next() ); return 1; }
+	bench_data & data;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct bench_result
+{
+	std::string instance, kernel;
+	double ns, misses, tlb_misses, ops;
+};
+
+bench_result measure( bench_kernel & k, const std::string & instance, double min_time )
+{
+	bench_counter counter, tlb_counter( bench_counter::tlb_misses );
+	bench_result r;
+	double t = 0, misses = 0, tlb_misses = 0;
+
+	r.instance = instance;
+	r.kernel = k.name();
+	r.ops = 0;
+
+	// Warm up
+	k.setup();
+	k.run();
+
+	while ( t < min_time )
+	{
+		chrono::time_point begin, end;
+
+		k.setup();
+		counter.start();
+		tlb_counter.start();
+		begin = chrono::now();
+		r.ops += k.run();
+		end = chrono::now();
+		tlb_misses += tlb_counter.stop();
+		misses += counter.stop();
+		t += end - begin;
+	}
+
+	r.ns = r.ops > 0 ? 1e9 * t / r.ops : 0;
+	r.misses = counter.ok() && r.ops > 0 ? misses / r.ops : -1;
+	r.tlb_misses = tlb_counter.ok() && r.ops > 0 ? tlb_misses / r.ops : -1;
+	return r;
+}
+
+// Generate a random instance: ROWSxCOLSxDENSITY, costs in [1,100]
+bool synthetic( const std::string & spec, scp_problem & instance )
+{
+	std::istringstream iss( spec );
+	int n = 0, m = 0;
+	double density = 0;
+	char x1 = 0, x2 = 0;
+
+	iss >> n >> x1 >> m >> x2 >> density;
+
+	if ( !iss || x1 != 'x' || x2 != 'x' || n <= 0 || m <= 1 || density <= 0 )
+	{
+		return false;
+	}
+
+	instance.clear();
+	instance.c.resize( m );
+	instance.S.resize( n );
+
+	for ( int i = 0; i < m; ++i )
+	{
+		instance.c[i] = 1 + std::rand() % 100;
+	}
+
+	for ( int j = 0; j < n; ++j )
+	{
+		int p = std::max( 2, int( density * m ) );
+
+		std::set<int> s;
+
+		while ( int( s.size() ) < p )
+		{
+			s.insert( std::rand() % m );
+		}
+		instance.S[j].assign( s.begin(), s.end() );
+	}
+	return true;
+}
+
+bool load( const std::string & filename, const std::string & format, scp_problem & instance )
+{
+	// Also reads uncompressed files
+	gz::ifstream file( filename.c_str() );
+
+	if ( !file.is_open() )
+	{
+		return false;
+	}
+
+	if ( format == "rail" )
+	{
+		return instance.read_rail( file );
+	}
+	else if ( format == "stn" )
+	{
+		return instance.read_stn( file );
+	}
+	return instance.read( file );
+}
+
+void read_baseline( const std::string & filename, std::map<std::string, double> & baseline )
+{
+	std::ifstream file( filename.c_str() );
+	std::string instance, kernel;
+	double ns;
+
+	while ( file >> instance >> kernel >> ns )
+	{
+		baseline[instance + " " + kernel] = ns;
+	}
+}
+
+void write_baseline( const std::string & filename, const std::vector<bench_result> & results )
+{
+	std::ofstream file( filename.c_str() );
+
+	for ( std::size_t k = 0; k < results.size(); ++k )
+	{
+		file << results[k].instance << ' ' << results[k].kernel << ' ' << results[k].ns << std::endl;
+	}
+}
+
+void print( const bench_result & r, const std::map<std::string, double> & baseline )
+{
+	std::map<std::string, double>::const_iterator it = baseline.find( r.instance + " " + r.kernel );
+
+	std::cout
+		<< std::left << std::setw( 24 ) << r.instance
+		<< std::setw( 24 ) << r.kernel
+		<< std::right << std::setw( 14 ) << std::fixed << std::setprecision( 1 ) << r.ns
+		<< std::setw( 10 ) << std::setprecision( 0 ) << r.ops;
+
+	if ( r.misses >= 0 )
+	{
+		std::cout << std::setw( 14 ) << std::setprecision( 2 ) << r.misses;
+	}
+	else
+	{
+		std::cout << std::setw( 14 ) << "-";
+	}
+
+	if ( r.tlb_misses >= 0 )
+	{
+		std::cout << std::setw( 14 ) << std::setprecision( 2 ) << r.tlb_misses;
+	}
+	else
+	{
+		std::cout << std::setw( 14 ) << "-";
+	}
+
+	if ( it != baseline.end() && it->second > 0 )
+	{
+		std::cout << std::setw( 10 ) << std::showpos << std::setprecision( 1 )
+		          << 100. * ( r.ns / it->second - 1 ) << "%" << std::noshowpos;
+	}
+	std::cout << std::endl;
+}
+
+int main( int argc, char * argv[] )
+{
+	docopt::option_group options;
+	docopt::parser opt_parser;
+
+	double alpha = 0.9, min_time = 0.5;
+	int pool_size = 16;
+	unsigned int seed = 1;
+	bool help = false;
+	std::string format = "scp", clock_str = "wall", pages_str = "normal", order_str, synthetic_str = "200x2000x0.02,500x5000x0.01",
+	            baseline_file, save_file;
+	std::vector<std::string> filenames;
+	std::map<std::string, double> baseline;
+	scp_order order = order_none;
+	std::vector<bench_result> results;
+	std::vector<std::string> specs;
+
+	options.name( "Options:" )
+		( "alpha",     'a', "FLOAT",  "RCL threshold parameter (in [0,1])" )
+		( "format",    'f', "FORMAT", "Instance file format (scp, rail, stn)" )
+		( "random",    'r', "INT",    "Random seed" )
+		( "time",      't', "FLOAT",  "Minimum measured time per kernel in seconds" )
+		( "pool",      'p', "INT",    "Number of input solutions per instance" )
+		( "synthetic", 's', "LIST",   "Synthetic instances ROWSxCOLSxDENSITY (comma-separated)" )
+		( "baseline",  'b', "FILE",   "Compare with a saved baseline" )
+		( "save",      'o', "FILE",   "Save the results as a baseline" )
+		( "clock",     'c', "CLOCK",  "Clock used to measure time (wall, process, thread, tsc)" )
+		( "huge-pages",     "PAGES",  "Pages of the large arrays (normal, thp, explicit)" )
+		( "renumber",       "ORDER",  "Renumber the rows and columns (none, cost, rcm)" )
+		( docopt::option::help() );
+
+	opt_parser
+		.add( options )
+		.bind( 'a', &alpha )
+		.bind( 'f', &format )
+		.bind( 'r', &seed )
+		.bind( 't', &min_time )
+		.bind( 'p', &pool_size )
+		.bind( 's', &synthetic_str )
+		.bind( 'b', &baseline_file )
+		.bind( 'o', &save_file )
+		.bind( 'c', &clock_str )
+		.bind( "huge-pages", &pages_str )
+		.bind( "renumber", &order_str )
+		.bind( '?', &help )
+		.bind_arguments( &filenames );
+
+	opt_parser.parse( argc, argv );
+
+	if ( help )
+	{
+		std::cout
+			<< "Usage: " << argv[0] << " [OPTIONS] [FILE...]" << std::endl
+			<< std::endl
+			<< options << std::endl;
+		return 0;
+	}
+
+	std::srand( seed );
+
+	if ( !chrono::clock( clock_str ) )
+	{
+		std::cerr << "Error: unknown clock '" << clock_str << "'" << std::endl;
+		return 0;
+	}
+
+	if ( !scp_memory::pages( pages_str ) )
+	{
+		std::cerr << "Error: unknown pages '" << pages_str << "'" << std::endl;
+		return 0;
+	}
+
+	if ( !scp_order_parse( order_str, order ) )
+	{
+		std::cerr << "Error: unknown order '" << order_str << "'" << std::endl;
+		return 0;
+	}
+
+	std::cout
+		<< "clock: " << chrono::name( chrono::clock() )
+		<< " | resolution = " << 1e9 * chrono::resolution( chrono::clock() ) << " ns"
+		<< " | overhead = " << 1e9 * chrono::overhead( chrono::clock() ) << " ns" << std::endl;
+
+	std::cout
+		<< "pages: " << scp_memory::name( scp_memory::pages() )
+		<< " | huge = " << scp_memory::huge_page_size() / 1024 << " KB"
+		<< " | order: " << scp_order_name( order ) << std::endl;
+
+	if ( !baseline_file.empty() )
+	{
+		read_baseline( baseline_file, baseline );
+	}
+
+	// Instances to benchmark
+	{
+		std::istringstream iss( synthetic_str );
+		std::string spec;
+
+		while ( std::getline( iss, spec, ',' ) )
+		{
+			if ( !spec.empty() ) specs.push_back( spec );
+		}
+		specs.insert( specs.end(), filenames.begin(), filenames.end() );
+	}
+
+	std::cout
+		<< std::left << std::setw( 24 ) << "instance"
+		<< std::setw( 24 ) << "kernel"
+		<< std::right << std::setw( 14 ) << "ns/op"
+		<< std::setw( 10 ) << "ops"
+		<< std::setw( 14 ) << "misses/op"
+		<< std::setw( 14 ) << "tlb/op"
+		<< std::setw( 11 ) << "baseline" << std::endl;
+
+	for ( std::size_t k = 0; k < specs.size(); ++k )
+	{
+		bool is_file = k >= specs.size() - filenames.size();
+		std::string name = is_file ? specs[k].substr( specs[k].find_last_of( '/' ) + 1 ) : specs[k];
+		bench_data data( name, alpha, pool_size > 0 ? pool_size : 1 );
+		std::vector<bench_kernel *> kernels;
+
+		data.grasp.rng.seed( seed );
+		data.repair.rng.seed( seed );
+
+		if ( is_file ? !load( specs[k], format, data.instance ) : !synthetic( specs[k], data.instance ) )
+		{
+			std::cerr << "Error: cannot load '" << specs[k] << "'" << std::endl;
+			continue;
+		}
+
+		if ( order != order_none )
+		{
+			scp_renumbering renumbering;
+
+			renumbering.build( data.instance, order );
+			renumbering.apply( data.instance );
+		}
+
+		if ( !data.init() )
+		{
+			std::cerr << "Error: infeasible instance '" << specs[k] << "'" << std::endl;
+			continue;
+		}
+
+		kernels.push_back( new bench_grasp_run( data ) );
+		kernels.push_back( new bench_grasp_add( data ) );
+		kernels.push_back( new bench_local_search( data, scp_local_search::_1_0, "local_search::run_1_0" ) );
+		kernels.push_back( new bench_local_search( data, scp_local_search::_1_1, "local_search::run_1_1" ) );
+		kernels.push_back( new bench_local_search( data, scp_local_search::_2_1, "local_search::run_2_1" ) );
+		kernels.push_back( new bench_repair( data ) );
+		kernels.push_back( new bench_check( data ) );
+
+		for ( int i = scp_score::isa_scalar; i <= scp_score::isa_avx512; ++i )
+		{
+			if ( scp_score::supported( scp_score::isa_type( i ) ) )
+			{
+				kernels.push_back( new bench_score( data, scp_score::isa_type( i ) ) );
+			}
+		}
+
+		kernels.push_back( new bench_index_build( data ) );
+
+		for ( std::size_t l = 0; l < kernels.size(); ++l )
+		{
+			results.push_back( measure( *kernels[l], name, min_time ) );
+			print( results.back(), baseline );
+			delete kernels[l];
+		}
+	}
+
+	if ( !save_file.empty() )
+	{
+		write_baseline( save_file, results );
+	}
+
+	return 0;
+}
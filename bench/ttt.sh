@@ -0,0 +1,139 @@
+#!/bin/bash
+
+# Time-to-target benchmark over the instance library
+#
+# For each instance and each seed, run the solver until the best known value
+# of best.txt is reached (or the time limit expires), and record the time to
+# target. The results are written in CSV and JSON formats.
+#
+# Usage: bench/ttt.sh [PATTERN...]
+#
+# PATTERN are shell patterns matched against the instance names of best.txt
+# (default: all of them, e.g. 'scp4*' 'rail*' 'stn*').
+#
+# Environment variables:
+#   SCP         solver executable (default: ./scp)
+#   BEST        best known values (default: best.txt)
+#   INSTANCES   instance directory (default: instances)
+#   SEEDS       random seeds (default: "1 2 3 4 5")
+#   TIME_LIMIT  time limit of each run in seconds (default: 60)
+#   OPTIONS     additional solver options (e.g. "--reactive")
+#   OUTPUT      output file prefix (default: ttt), writes OUTPUT.csv and OUTPUT.json
+
+SCP=${SCP:-./scp}
+BEST=${BEST:-best.txt}
+INSTANCES=${INSTANCES:-instances}
+SEEDS=${SEEDS:-1 2 3 4 5}
+TIME_LIMIT=${TIME_LIMIT:-60}
+OUTPUT=${OUTPUT:-ttt}
+
+[ -x "$SCP" ] || { echo "Error: solver '$SCP' not found (run make first)"; exit 1; }
+[ -f "$BEST" ] || { echo "Error: best known values '$BEST' not found"; exit 1; }
+
+[ $# -gt 0 ] || set -- '*'
+
+instance_file()
+{
+	for f in "$INSTANCES/$1.txt" "$INSTANCES/$1.txt.gz" "$INSTANCES/$1.gz"
+	do
+		if [ -f "$f" ]
+		then
+			echo "$f"
+			return
+		fi
+	done
+}
+
+instance_format()
+{
+	case "$1" in
+		rail*) echo rail ;;
+		stn*)  echo stn ;;
+		*)     echo scp ;;
+	esac
+}
+
+csv="$OUTPUT.csv"
+json="$OUTPUT.json"
+
+echo "instance,format,seed,target,best,iterations,time_to_target,avg_ms,reached" > "$csv"
+
+while read name target
+do
+	[ -n "$name" ] || continue
+
+	selected=0
+	for pattern in "$@"
+	do
+		case "$name" in
+			$pattern) selected=1 ;;
+		esac
+	done
+	[ $selected -eq 1 ] || continue
+
+	file=$(instance_file "$name")
+	if [ -z "$file" ]
+	then
+		echo "Skip $name: no instance file in '$INSTANCES'" >&2
+		continue
+	fi
+	format=$(instance_format "$name")
+
+	for seed in $SEEDS
+	do
+		# Quiet output: MIN_GAP AVG_GAP MAX_GAP AVG_MS BEST ITERATIONS TIME_TO_TARGET
+		result=($("$SCP" -q -n 0 -f "$format" -r "$seed" \
+		          --time-limit "$TIME_LIMIT" --target "$target" $OPTIONS "$file"))
+
+		if [ ${#result[@]} -lt 7 ]
+		then
+			echo "Error: $name (seed $seed) failed" >&2
+			continue
+		fi
+
+		avg_ms=${result[3]}
+		best=${result[4]}
+		iterations=${result[5]}
+		ttt=${result[6]}
+		reached=true
+		if [ "$ttt" = "-1" ]
+		then
+			reached=false
+			ttt=$TIME_LIMIT
+		fi
+
+		echo "$name $seed: best = $best | target = $target | time = $ttt s | reached = $reached"
+		echo "$name,$format,$seed,$target,$best,$iterations,$ttt,$avg_ms,$reached" >> "$csv"
+	done
+done < "$BEST"
+
+# Convert CSV to JSON
+awk -F, '
+	NR == 1 { for ( i = 1; i <= NF; ++i ) key[i] = $i; print "["; next }
+	{
+		printf "%s  {", ( NR > 2 ? ",\n" : "" )
+		for ( i = 1; i <= NF; ++i )
+		{
+			value = ( key[i] == "instance" || key[i] == "format" ) ? "\"" $i "\"" : $i
+			printf "%s\"%s\": %s", ( i > 1 ? ", " : "" ), key[i], value
+		}
+		printf "}"
+	}
+	END { if ( NR > 1 ) print ""; print "]" }
+' "$csv" > "$json"
+
+# Summary per instance
+echo
+echo "instance  runs  reached  avg_time_to_target"
+awk -F, '
+	NR > 1 {
+		if ( !( $1 in runs ) ) name[++count] = $1
+		runs[$1]++
+		sum[$1] += $7
+		if ( $9 == "true" ) reached[$1]++
+	}
+	END { for ( k = 1; k <= count; ++k ) { i = name[k]; printf "%-9s %4d  %7d  %18.3f\n", i, runs[i], reached[i], sum[i] / runs[i] } }
+' "$csv"
+
+echo
+echo "Results written to $csv and $json"
@@ -16,53 +16,78 @@
 #ifndef CHRONO_HPP
 #define CHRONO_HPP
 
-#include <sys/time.h>
-#include <sys/resource.h>
-#include <ctime>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <string>
 #include <iostream>
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#define _CHRONO_TSC 1
+#else
+#define _CHRONO_TSC 0
+#endif
 
-#define _CHRONO_GETRUSAGE 0
-
-struct chrono_time_point_clock;
-struct chrono_time_point_getrusage;
+struct chrono_time_point;
 
 /*
 	Class: chrono
 
 	A clock to measure execution time.
+
+	The clock is chosen at runtime:
+
+	- wall:    monotonic wall clock (default),
+	- process: CPU time of the process (sum over all threads),
+	- thread:  CPU time of the calling thread,
+	- tsc:     time stamp counter, the cheapest to read, calibrated against
+	           the wall clock at first use (wall clock if not available).
+
+	The calibration busy waits for 10 ms, once for all the threads. It is
+	done when the tsc clock is selected, and a program that reads it with
+	now( tsc ) should call <tsc_frequency> before timing, so that the
+	wait is not in the measures.
 */
 struct chrono
 {
-#if _CHRONO_GETRUSAGE
-	typedef chrono_time_point_getrusage time_point;
-#else
-	typedef chrono_time_point_clock time_point;
-#endif
+	enum clock_type
+	{
+		wall,
+		process,
+		thread,
+		tsc
+	};
+
+	typedef chrono_time_point time_point;
 
 	static time_point now();
+	static time_point now( clock_type c );
 	static double diff( const time_point & end, const time_point & beg, double r = 1 );
-};
 
-// Using std::clock()
-struct chrono_time_point_clock
-{
-	chrono_time_point_clock() {}
+	static clock_type clock();
+	static void clock( clock_type c );
+	static bool clock( const std::string & name );
+	static const char * name( clock_type c );
 
-private:
-	chrono_time_point_clock( std::clock_t t ) : _t( t ) {}
-	std::clock_t _t;
+	static double resolution( clock_type c );
+	static double overhead( clock_type c );
+	static double tsc_frequency();
 
-	friend struct chrono;
+private:
+	static clock_type & _clock();
+	static int64_t _nanoseconds( clockid_t id );
+	static double & _tsc_frequency();
+	static void _calibrate();
 };
 
-// Using getrusage()
-struct chrono_time_point_getrusage
+struct chrono_time_point
 {
-	chrono_time_point_getrusage() {}
+	chrono_time_point() : _t( 0 ), _c( chrono::wall ) {}
 
 private:
-	chrono_time_point_getrusage( const timeval & t ) : _t( t ) {}
-	timeval _t;
+	chrono_time_point( int64_t t, chrono::clock_type c ) : _t( t ), _c( c ) {}
+	int64_t _t;
+	chrono::clock_type _c;
 
 	friend struct chrono;
 };
@@ -73,25 +98,166 @@ double operator - ( const chrono::time_point & end, const chrono::time_point & b
 
 inline chrono::time_point chrono::now()
 {
-#if _CHRONO_GETRUSAGE
-	rusage r;
-	getrusage( RUSAGE_SELF, &r );
-	return time_point( r.ru_utime );
+	return now( _clock() );
+}
+
+inline chrono::time_point chrono::now( clock_type c )
+{
+	switch ( c )
+	{
+		case tsc:
+#if _CHRONO_TSC
+			return time_point( __rdtsc(), c );
 #else
-	return time_point( std::clock() );
+			return time_point( _nanoseconds( CLOCK_MONOTONIC ), wall );
 #endif
+		case process:
+			return time_point( _nanoseconds( CLOCK_PROCESS_CPUTIME_ID ), c );
+		case thread:
+			return time_point( _nanoseconds( CLOCK_THREAD_CPUTIME_ID ), c );
+		case wall:
+		default:
+			return time_point( _nanoseconds( CLOCK_MONOTONIC ), wall );
+	}
 }
 
 inline double chrono::diff( const time_point & end, const time_point & beg, double r )
 {
-#if _CHRONO_GETRUSAGE
-	return double( end._t.tv_sec - beg._t.tv_sec ) / r
-	     + double( end._t.tv_usec - beg._t.tv_usec ) / r / 1e6;
+	if ( end._c == tsc )
+	{
+		return double( end._t - beg._t ) / r / tsc_frequency();
+	}
+	return double( end._t - beg._t ) / r / 1e9;
+}
+
+inline chrono::clock_type chrono::clock()
+{
+	return _clock();
+}
+
+inline void chrono::clock( clock_type c )
+{
+	if ( c == tsc )
+	{
+		// Calibrate before any measurement
+		tsc_frequency();
+	}
+	_clock() = c;
+}
+
+inline bool chrono::clock( const std::string & name )
+{
+	for ( int c = wall; c <= tsc; ++c )
+	{
+		if ( name == chrono::name( clock_type( c ) ) )
+		{
+			clock( clock_type( c ) );
+			return true;
+		}
+	}
+	return false;
+}
+
+inline const char * chrono::name( clock_type c )
+{
+	switch ( c )
+	{
+		case process: return "process";
+		case thread:  return "thread";
+		case tsc:     return "tsc";
+		case wall:
+		default:      return "wall";
+	}
+}
+
+// Smallest measurable duration in seconds
+inline double chrono::resolution( clock_type c )
+{
+	timespec r = { 0, 0 };
+
+	switch ( c )
+	{
+		case tsc:
+#if _CHRONO_TSC
+			return 1 / tsc_frequency();
+#endif
+		case wall:
+			clock_getres( CLOCK_MONOTONIC, &r );
+			break;
+		case process:
+			clock_getres( CLOCK_PROCESS_CPUTIME_ID, &r );
+			break;
+		case thread:
+			clock_getres( CLOCK_THREAD_CPUTIME_ID, &r );
+			break;
+	}
+	return double( r.tv_sec ) + double( r.tv_nsec ) / 1e9;
+}
+
+// Average cost of a call to now() in seconds
+inline double chrono::overhead( clock_type c )
+{
+	const int n = 1000;
+	time_point begin = now( c ), end;
+
+	for ( int k = 0; k < n; ++k )
+	{
+		end = now( c );
+	}
+	return diff( end, begin, n );
+}
+
+// Ticks per second of the time stamp counter, calibrated by the first
+// call of any thread
+inline double chrono::tsc_frequency()
+{
+#if _CHRONO_TSC
+	static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+	pthread_once( &once, _calibrate );
+	return _tsc_frequency();
 #else
-	return ( end._t - beg._t ) / r / CLOCKS_PER_SEC;
+	return 1e9;
+#endif
+}
+
+inline chrono::clock_type & chrono::_clock()
+{
+	static clock_type c = wall;
+	return c;
+}
+
+inline double & chrono::_tsc_frequency()
+{
+	static double f = 0;
+	return f;
+}
+
+inline void chrono::_calibrate()
+{
+#if _CHRONO_TSC
+	int64_t t0 = _nanoseconds( CLOCK_MONOTONIC ), t1;
+	uint64_t r0 = __rdtsc(), r1;
+
+	// Busy wait for 10 ms
+	do
+	{
+		t1 = _nanoseconds( CLOCK_MONOTONIC );
+		r1 = __rdtsc();
+	}
+	while ( t1 - t0 < 10000000 );
+
+	_tsc_frequency() = double( r1 - r0 ) * 1e9 / double( t1 - t0 );
 #endif
 }
 
+inline int64_t chrono::_nanoseconds( clockid_t id )
+{
+	timespec t;
+	clock_gettime( id, &t );
+	return int64_t( t.tv_sec ) * 1000000000 + t.tv_nsec;
+}
+
 inline double operator - ( const chrono::time_point & end, const chrono::time_point & begin )
 {
 	return chrono::diff( end, begin );
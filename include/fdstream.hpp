@@ -0,0 +1,221 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FDSTREAM_HPP
+#define FDSTREAM_HPP
+
+#include <ios>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <algorithm>
+#include <cstdio>
+#include <cerrno>
+#include <unistd.h>
+
+namespace fd
+{
+
+/*
+	Class: fd::streambuf
+
+	A stream buffer over a file descriptor (socket, pipe), with separate
+	input and output buffers. The descriptor is not closed.
+*/
+struct streambuf : std::streambuf
+{
+	streambuf( int fd = -1 );
+	~streambuf();
+
+	int fd() const;
+	void attach( int fd );
+
+protected:
+	virtual int_type overflow( int_type c = traits_type::eof() );
+	virtual int_type underflow();
+	virtual int_type sync();
+
+private:
+	static const int _size = 4096;
+	int              _fd;
+	char_type        _in[_size];
+	char_type        _out[_size];
+
+	int_type _flush();
+};
+
+/*
+	Class: fd::iostream
+
+	Input/output stream over a file descriptor.
+*/
+struct iostream : std::iostream
+{
+	iostream( int fd = -1 );
+
+	int fd() const;
+	void attach( int fd );
+
+	streambuf * rdbuf();
+
+protected:
+	streambuf _buf;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline streambuf::streambuf( int fd )
+{
+	attach( fd );
+}
+
+inline streambuf::~streambuf()
+{
+	sync();
+}
+
+inline int streambuf::fd() const
+{
+	return _fd;
+}
+
+inline void streambuf::attach( int fd )
+{
+	_fd = fd;
+	setp( _out, _out + ( _size - 1 ) );
+	setg( _in + 4, _in + 4, _in + 4 );
+}
+
+inline streambuf::int_type streambuf::overflow( int_type c )
+{
+	if ( _fd < 0 )
+	{
+		return EOF;
+	}
+
+	if ( c != EOF )
+	{
+		*pptr() = c;
+		pbump( 1 );
+	}
+
+	if ( _flush() == EOF )
+	{
+		return EOF;
+	}
+	return c;
+}
+
+inline streambuf::int_type streambuf::underflow()
+{
+	if ( gptr() && gptr() < egptr() )
+	{
+		return *reinterpret_cast<unsigned char *>( gptr() );
+	}
+
+	if ( _fd < 0 )
+	{
+		return EOF;
+	}
+
+	int_type n_putback = gptr() - eback();
+
+	if ( n_putback > 4 )
+	{
+		n_putback = 4;
+	}
+
+	std::copy( gptr() - n_putback, gptr(), _in + ( 4 - n_putback ) );
+
+	ssize_t n;
+
+	do
+	{
+		n = ::read( _fd, _in + 4, _size - 4 );
+	}
+	while ( n < 0 && errno == EINTR );
+
+	if ( n <= 0 )
+	{
+		return EOF;
+	}
+
+	setg( _in + ( 4 - n_putback ), _in + 4, _in + 4 + n );
+
+	return *reinterpret_cast<unsigned char *>( gptr() );
+}
+
+inline streambuf::int_type streambuf::sync()
+{
+	if ( pptr() && pptr() > pbase() && _flush() == EOF )
+	{
+		return -1;
+	}
+	return 0;
+}
+
+inline streambuf::int_type streambuf::_flush()
+{
+	int_type w = pptr() - pbase();
+	const char_type * p = pbase();
+
+	while ( p < pptr() )
+	{
+		ssize_t n = ::write( _fd, p, pptr() - p );
+
+		if ( n < 0 && errno == EINTR )
+		{
+			continue;
+		}
+
+		if ( n <= 0 )
+		{
+			pbump( -w );
+			return EOF;
+		}
+		p += n;
+	}
+
+	pbump( -w );
+	return w;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline iostream::iostream( int fd ) :
+	std::iostream( &_buf ),
+	_buf( fd )
+{
+}
+
+inline int iostream::fd() const
+{
+	return _buf.fd();
+}
+
+inline void iostream::attach( int fd )
+{
+	_buf.attach( fd );
+	clear();
+}
+
+inline streambuf * iostream::rdbuf()
+{
+	return &_buf;
+}
+
+}
+
+#endif
@@ -30,7 +30,9 @@ namespace gz
 /*
 	Class: gz::filebuf
 
-	A gzip file stream buffer.
+	A gzip file stream buffer. When writing, the compression level can be
+	given from 0 (none) to 9 (best), -1 being the zlib default, and large
+	writes bypass the buffer.
 */
 struct filebuf : std::streambuf
 {
@@ -38,16 +40,17 @@ struct filebuf : std::streambuf
 	~filebuf();
 
 	bool is_open() const;
-	filebuf * open( const char * name, std::ios_base::openmode mode );
+	filebuf * open( const char * name, std::ios_base::openmode mode, int level = -1 );
 	filebuf * close();
 
 protected:
 	virtual int_type overflow( int_type c = traits_type::eof() );
+	virtual std::streamsize xsputn( const char_type * s, std::streamsize n );
 	virtual int_type underflow();
 	virtual int_type sync();
 
 private:
-	static const int        _size = 47+256;
+	static const int        _size = 1 << 16;
 	gzFile                  _file;
 	char_type               _buffer[_size];
 	bool                    _open;
@@ -64,11 +67,11 @@ private:
 struct basic_fstream : virtual std::ios
 {
 	basic_fstream();
-	basic_fstream( const char * name, std::ios_base::openmode mode );
+	basic_fstream( const char * name, std::ios_base::openmode mode, int level = -1 );
 	~basic_fstream();
 
 	bool is_open();
-	void open( const char * name, std::ios_base::openmode mode );
+	void open( const char * name, std::ios_base::openmode mode, int level = -1 );
 	void close();
 
 	filebuf * rdbuf();
@@ -97,8 +100,8 @@ struct ifstream : basic_fstream, std::istream
 struct ofstream : basic_fstream, std::ostream
 {
 	ofstream();
-	ofstream( const char * name, std::ios_base::openmode mode = std::ios::out );
-	void open( const char * name, std::ios_base::openmode mode = std::ios::out );
+	ofstream( const char * name, std::ios_base::openmode mode = std::ios::out, int level = -1 );
+	void open( const char * name, std::ios_base::openmode mode = std::ios::out, int level = -1 );
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -120,7 +123,7 @@ inline bool filebuf::is_open() const
 	return _open;
 }
 
-inline filebuf * filebuf::open( const char * name, std::ios_base::openmode mode )
+inline filebuf * filebuf::open( const char * name, std::ios_base::openmode mode, int level )
 {
 	if ( is_open() )
 	{
@@ -148,6 +151,10 @@ inline filebuf * filebuf::open( const char * name, std::ios_base::openmode mode
 		*fmodeptr++ = 'w';
 	}
 	*fmodeptr++ = 'b';
+	if ( ( _mode & std::ios::out ) && 0 <= level && level <= 9 )
+	{
+		*fmodeptr++ = '0' + level;
+	}
 	*fmodeptr = 0;
 
 	if ( !( _file = gzopen( name, fmode ) ) )
@@ -155,6 +162,11 @@ inline filebuf * filebuf::open( const char * name, std::ios_base::openmode mode
 		return 0;
 	}
 
+#if ZLIB_VERNUM >= 0x1240
+	// Larger zlib buffers mean fewer system calls
+	gzbuffer( _file, 1 << 17 );
+#endif
+
 	_open = true;
 	return this;
 }
@@ -194,6 +206,33 @@ inline filebuf::int_type filebuf::overflow( int_type c )
 	return c;
 }
 
+inline std::streamsize filebuf::xsputn( const char_type * s, std::streamsize n )
+{
+	if ( n < epptr() - pptr() )
+	{
+		std::copy( s, s + n, pptr() );
+		pbump( n );
+		return n;
+	}
+
+	if ( !( _mode & std::ios::out ) || !_open )
+	{
+		return 0;
+	}
+
+	// Write the buffer, then the data directly
+	if ( pptr() > pbase() && _flush() == EOF )
+	{
+		return 0;
+	}
+
+	if ( gzwrite( _file, s, n ) != n )
+	{
+		return 0;
+	}
+	return n;
+}
+
 inline filebuf::int_type filebuf::underflow()
 {
 	if ( gptr() && gptr() < egptr() )
@@ -227,12 +266,19 @@ inline filebuf::int_type filebuf::underflow()
 	return *reinterpret_cast<unsigned char *>( gptr() );
 }
 
+// Write the buffer and flush the compressor, so that the data written so
+// far can be decompressed even if the file is not closed
 inline filebuf::int_type filebuf::sync()
 {
 	if ( pptr() && pptr() > pbase() && _flush() == EOF )
 	{
 		return -1;
 	}
+
+	if ( _open && ( _mode & std::ios::out ) && gzflush( _file, Z_SYNC_FLUSH ) != Z_OK )
+	{
+		return -1;
+	}
 	return 0;
 }
 
@@ -256,10 +302,10 @@ inline basic_fstream::basic_fstream()
 	init( &_buf );
 }
 
-inline basic_fstream::basic_fstream( const char * name, std::ios_base::openmode mode )
+inline basic_fstream::basic_fstream( const char * name, std::ios_base::openmode mode, int level )
 {
 	init( &_buf );
-	open( name, mode );
+	open( name, mode, level );
 }
 
 inline basic_fstream::~basic_fstream()
@@ -272,9 +318,9 @@ inline bool basic_fstream::is_open()
 	return _buf.is_open();
 }
 
-inline void basic_fstream::open( const char * name, std::ios_base::openmode mode )
+inline void basic_fstream::open( const char * name, std::ios_base::openmode mode, int level )
 {
-	if ( !_buf.open( name, mode ) )
+	if ( !_buf.open( name, mode, level ) )
 	{
 		clear( rdstate() | std::ios::badbit );
 	}
@@ -325,15 +371,15 @@ inline ofstream::ofstream() :
 	init( &_buf );
 }
 
-inline ofstream::ofstream( const char * name, std::ios_base::openmode mode ) :
-	basic_fstream( name, mode ),
+inline ofstream::ofstream( const char * name, std::ios_base::openmode mode, int level ) :
+	basic_fstream( name, mode, level ),
 	std::ostream( &_buf )
 {
 }
 
-inline void ofstream::open( const char * name, std::ios_base::openmode mode )
+inline void ofstream::open( const char * name, std::ios_base::openmode mode, int level )
 {
-	if ( !_buf.open( name, mode ) )
+	if ( !_buf.open( name, mode, level ) )
 	{
 		clear( rdstate() | std::ios::badbit );
 	}
@@ -0,0 +1,121 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCP_BATCH_HPP
+#define SCP_BATCH_HPP
+
+#include <pthread.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include "scp_problem.hpp"
+#include "scp_io.hpp"
+#include "scp_driver.hpp"
+
+/*
+	Class: scp_batch_job
+
+	Parameters of a job of <scp_batch>. A null (or negative) limit means no
+	limit. Without a target, the reference value of the gaps is computed by
+	CPLEX.
+*/
+struct scp_batch_job
+{
+	scp_batch_job();
+
+	bool set( const std::string & key, const std::string & value );
+	bool stopping() const;
+	void apply( scp_driver & driver ) const;
+
+	int id;
+	std::string filename;
+	scp_format format;
+	double alpha,
+	       epsilon,
+	       time_limit,
+	       target;
+	int num_runs,
+	    stall_iterations,
+	    block,
+	    verify;
+	unsigned int seed;
+	bool reactive;
+	std::string alphas;
+};
+
+/*
+	Class: scp_batch
+
+	Batch mode: solves the jobs of a manifest with a pool of threads, and
+	writes one result line per job as soon as it is done.
+
+	Each line of the manifest is a job: an instance file followed by
+	KEY=VALUE parameters (format, alpha, epsilon, n, seed, target,
+	time-limit, stall-iterations, reactive, alphas, block, verify). The
+	seed can be a range A-B, which gives one job per seed. Empty lines and
+	lines starting with '#' are ignored.
+
+	A loader thread reads the instances ahead while the workers solve, and
+	the jobs on the same instance share a single copy of it and of its
+	index, released after the last one, as well as its reference value,
+	computed by the loader when a job has no target.
+*/
+struct scp_batch
+{
+	scp_batch();
+	~scp_batch();
+
+	bool read( std::istream & is, const scp_batch_job & defaults );
+	void run( int num_threads, std::ostream & os );
+
+	int size() const;
+
+private:
+	struct slot
+	{
+		std::string filename;
+		scp_format format;
+		scp_problem * instance;
+		scp_index * index;
+		std::vector<int> jobs;
+		int remaining;
+		double z_ref;
+		bool failed,
+		     cplex_failed;
+	};
+
+	std::vector<scp_batch_job> _jobs;
+	std::vector<int> _job_slot;
+	std::vector<slot> _slots;
+
+	std::deque<int> _ready;
+	int _resident, _max_resident;
+	bool _loaded;
+	std::ostream * _os;
+
+	pthread_mutex_t _mutex;
+	pthread_cond_t _cond_ready, _cond_loader;
+
+	static void * _loader( void * self );
+	static void * _worker( void * self );
+
+	void _load();
+	void _work();
+	bool _pop( int & job );
+	void _finish( int job, const std::string & result );
+};
+
+#endif
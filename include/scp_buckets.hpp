@@ -0,0 +1,225 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCP_BUCKETS_HPP
+#define SCP_BUCKETS_HPP
+
+#include <vector>
+#include <algorithm>
+#include "scp_memory.hpp"
+
+/*
+	Class: scp_buckets
+
+	Bucket queue of the columns keyed by a non-negative integer (the number
+	of uncovered rows of a column on unicost instances), whose keys only
+	decrease.
+
+	The columns are kept sorted by key in a single array, each bucket being
+	a contiguous range: decrementing a key swaps the column with the first
+	one of its bucket, and moves the start of the bucket, in constant time.
+	The columns with a key at least k are then the range [start(k), size),
+	and the smallest and largest keys are read at its ends.
+
+	<build> sorts the initial keys once, and <reset> restores them without
+	allocation: only the columns moved since the last reset, which are
+	listed by <decrement>, or all of them by a copy if they are most.
+*/
+struct scp_buckets
+{
+	void build( const std::vector<int> & key );
+	void reset();
+
+	int size() const;
+	int key( int i ) const;
+	void decrement( int i );
+
+	int start( int k ) const;
+	int operator [] ( int p ) const;
+
+	int min_positive() const;
+	int max() const;
+
+	std::size_t memory() const;
+
+private:
+	std::vector< int, scp_allocator<int> > _key, _order, _position, _start,
+	                                      _key0, _order0, _position0, _start0;
+
+	// Columns moved since the last reset, and whether each one is listed
+	std::vector<int> _touched;
+	std::vector<char> _is_touched;
+
+	void _touch( int i );
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Counting sort of the columns by key
+inline void scp_buckets::build( const std::vector<int> & key )
+{
+	int m = key.size(), k_max = 0;
+
+	for ( int i = 0; i < m; ++i )
+	{
+		if ( key[i] > k_max ) k_max = key[i];
+	}
+
+	_key0.assign( key.begin(), key.end() );
+	_order0.assign( m, 0 );
+	_position0.assign( m, 0 );
+	_start0.assign( k_max + 2, 0 );
+
+	for ( int i = 0; i < m; ++i )
+	{
+		++_start0[key[i] + 1];
+	}
+
+	for ( int k = 0; k <= k_max; ++k )
+	{
+		_start0[k+1] += _start0[k];
+	}
+
+	// Uses the start of the next bucket as a cursor, then shifts it back
+	for ( int i = 0; i < m; ++i )
+	{
+		int p = _start0[key[i]]++;
+
+		_order0[p] = i;
+		_position0[i] = p;
+	}
+
+	for ( int k = k_max; k > 0; --k )
+	{
+		_start0[k] = _start0[k-1];
+	}
+	_start0[0] = 0;
+
+	_key = _key0;
+	_order = _order0;
+	_position = _position0;
+	_start = _start0;
+
+	_touched.clear();
+	_touched.reserve( m );
+	_is_touched.assign( m, 0 );
+}
+
+// A decrement swaps two columns, both listed as moved: the moved columns
+// then hold the positions they had at the last reset, among themselves.
+// The starts, one per key, are copied
+inline void scp_buckets::reset()
+{
+	std::size_t m = _key.size();
+
+	if ( 2 * _touched.size() > m )
+	{
+		std::copy( _key0.begin(), _key0.end(), _key.begin() );
+		std::copy( _order0.begin(), _order0.end(), _order.begin() );
+		std::copy( _position0.begin(), _position0.end(), _position.begin() );
+
+		for ( std::size_t p = 0; p < _touched.size(); ++p )
+		{
+			_is_touched[_touched[p]] = 0;
+		}
+	}
+	else
+	{
+		for ( std::size_t p = 0; p < _touched.size(); ++p )
+		{
+			int i = _touched[p];
+
+			_key[i] = _key0[i];
+			_order[_position0[i]] = i;
+			_position[i] = _position0[i];
+			_is_touched[i] = 0;
+		}
+	}
+
+	std::copy( _start0.begin(), _start0.end(), _start.begin() );
+	_touched.clear();
+}
+
+inline int scp_buckets::size() const
+{
+	return _order.size();
+}
+
+inline int scp_buckets::key( int i ) const
+{
+	return _key[i];
+}
+
+// The column moves to the end of the previous bucket
+inline void scp_buckets::decrement( int i )
+{
+	int k = _key[i],
+	    p = _position[i],
+	    q = _start[k]++,
+	    j = _order[q];
+
+	_touch( i );
+	_touch( j );
+
+	_order[p] = j;
+	_position[j] = p;
+	_order[q] = i;
+	_position[i] = q;
+	--_key[i];
+}
+
+// Position of the first column with a key at least k
+inline int scp_buckets::start( int k ) const
+{
+	return k < int( _start.size() ) ? _start[k] : size();
+}
+
+inline int scp_buckets::operator [] ( int p ) const
+{
+	return _order[p];
+}
+
+// Smallest positive key, 0 if there is none
+inline int scp_buckets::min_positive() const
+{
+	int p = start( 1 );
+	return p < size() ? _key[_order[p]] : 0;
+}
+
+inline int scp_buckets::max() const
+{
+	return _order.empty() ? 0 : _key[_order.back()];
+}
+
+// Number of bytes used
+inline std::size_t scp_buckets::memory() const
+{
+	return sizeof( *this )
+	     + ( _key.capacity() + _order.capacity() + _position.capacity() + _start.capacity()
+	       + _key0.capacity() + _order0.capacity() + _position0.capacity() + _start0.capacity()
+	       + _touched.capacity() ) * sizeof( int )
+	     + _is_touched.capacity();
+}
+
+inline void scp_buckets::_touch( int i )
+{
+	if ( !_is_touched[i] )
+	{
+		_is_touched[i] = 1;
+		_touched.push_back( i );
+	}
+}
+
+#endif
@@ -0,0 +1,106 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCP_COSTS_HPP
+#define SCP_COSTS_HPP
+
+#include <vector>
+#include "scp_problem.hpp"
+#include "scp_memory.hpp"
+
+/*
+	Class: scp_costs
+
+	Copy of the costs kept by a solver: as int when they are all integral
+	(see <scp_integral>), which halves its size and makes the sums and
+	comparisons exact, and as double otherwise.
+
+	The solvers read a cost with operator[], and scan them with the typed
+	pointer data<C>(), C being int if <integral> and double otherwise.
+*/
+struct scp_costs
+{
+	void assign( const std::vector<double> & c );
+	void clear();
+
+	bool integral() const;
+	int size() const;
+
+	double operator[]( int i ) const;
+	template <class C> const C * data() const;
+
+	std::size_t memory() const;
+
+private:
+	std::vector< double, scp_allocator<double> > _c;
+	std::vector< int, scp_allocator<int> > _ci;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline void scp_costs::assign( const std::vector<double> & c )
+{
+	clear();
+
+	if ( scp_integral( c ) )
+	{
+		_ci.assign( c.begin(), c.end() );
+	}
+	else
+	{
+		_c.assign( c.begin(), c.end() );
+	}
+}
+
+inline void scp_costs::clear()
+{
+	_c.clear();
+	_ci.clear();
+}
+
+// Whether the costs are stored as int, also true without costs
+inline bool scp_costs::integral() const
+{
+	return _c.empty();
+}
+
+inline int scp_costs::size() const
+{
+	return _c.empty() ? _ci.size() : _c.size();
+}
+
+inline double scp_costs::operator[]( int i ) const
+{
+	return _c.empty() ? _ci[i] : _c[i];
+}
+
+template <>
+inline const double * scp_costs::data<double>() const
+{
+	return _c.empty() ? 0 : &_c[0];
+}
+
+template <>
+inline const int * scp_costs::data<int>() const
+{
+	return _ci.empty() ? 0 : &_ci[0];
+}
+
+inline std::size_t scp_costs::memory() const
+{
+	return sizeof( *this ) + _c.capacity() * sizeof( double ) + _ci.capacity() * sizeof( int );
+}
+
+#endif
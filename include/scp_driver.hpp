@@ -0,0 +1,426 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCP_DRIVER_HPP
+#define SCP_DRIVER_HPP
+
+#include <iostream>
+#include <vector>
+#include <limits>
+#include <stdexcept>
+#include "scp_problem.hpp"
+#include "scp_grasp.hpp"
+#include "scp_local_search.hpp"
+#include "scp_reactive.hpp"
+#include "scp_stop.hpp"
+#include "scp_io.hpp"
+
+/*
+	Class: scp_driver
+
+	Main loop of the metaheuristic: a GRASP construction followed by a
+	local search, repeated until the stopping criteria are met.
+
+	A driver owns its solvers and random number generators, so that several
+	drivers can run in parallel threads. It can be reused for several
+	instances.
+
+	On instances with integral costs (see <scp_integral>), the objective
+	values are sums of integers, exact in double, so they are compared
+	without epsilon by the stopping criteria and the checks.
+
+	A driver can also gather the tries of the copies run by other threads
+	(see <merge> and <scp_parallel>), as if it had run them.
+
+	The rows are only read from the index, so that the instance may hold
+	only the costs when the index is shared by several processes (see
+	<scp_island>).
+*/
+struct scp_driver
+{
+	scp_driver();
+
+	void read( const scp_problem & instance );
+	void read( const scp_problem & instance, const scp_index & index );
+	void seed( uint64_t s );
+
+	void start();
+	bool done() const;
+	void iterate();
+	void run();
+	bool migrate( double z, const scp_solution & x );
+	void merge( const scp_driver & driver );
+
+	const scp_problem & instance() const;
+	const scp_index & index() const;
+
+	double z() const;
+	const scp_solution & x() const;
+	int iterations() const;
+	double elapsed() const;
+
+	std::size_t memory() const;
+
+	double min_gap() const;
+	double avg_gap() const;
+	double max_gap() const;
+
+	double alpha,
+	       epsilon,
+	       z_ref;
+	bool reactive;
+
+	// Period of the full check of the solutions against the instance, in
+	// iterations (0 for never). Otherwise, the feasibility and objective
+	// values kept up to date by the solvers are trusted
+	int verify;
+
+	// Iteration log, or null
+	std::ostream * log;
+
+	// Stream of the improved solutions (elapsed time, objective value and
+	// columns on one line), or null
+	std::ostream * incumbents;
+
+	// Stream of all the local search solutions, or null
+	std::ostream * pool;
+
+	// Original number of each column, written to the streams above if the
+	// instance is renumbered (see <scp_renumbering>), or null
+	const std::vector<int> * columns;
+
+	// Weights scored by GRASP in place of the costs, such as the reduced
+	// costs of <scp_lp>, or null. Applied by read()
+	const std::vector<double> * weights;
+
+	scp_grasp grasp;
+	scp_local_search local_search;
+	scp_reactive reactive_alpha;
+	scp_stop stop;
+
+private:
+	const scp_problem * _instance;
+	const scp_index * _index;
+	scp_index _own_index;
+	scp_solution _x;
+	double _min_gap, _max_gap, _sum_gap, _elapsed;
+	bool _integral;
+
+	double _epsilon() const;
+	bool _check( const scp_solution & x, double z ) const;
+	void _record( double alpha, double z_g, double z_ls, const scp_solution & x );
+	void _write_incumbent( double t, double z, const scp_solution & x );
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline scp_driver::scp_driver() :
+	alpha( 0.9 ), epsilon( 1e-9 ), z_ref( 0 ), reactive( false ), verify( 0 ), log( 0 ), incumbents( 0 ), pool( 0 ), columns( 0 ), weights( 0 ),
+	_instance( 0 ), _index( 0 ), _integral( false )
+{
+	local_search.stop = &stop;
+	start();
+}
+
+inline void scp_driver::read( const scp_problem & instance )
+{
+	_own_index.build( instance );
+	read( instance, _own_index );
+}
+
+// Share an index of the instance, which must outlive the driver
+inline void scp_driver::read( const scp_problem & instance, const scp_index & index )
+{
+	_instance = &instance;
+	_index = &index;
+	_integral = instance.integral();
+	_x.resize( instance.num_elements() );
+	grasp.read( instance, index );
+	local_search.read( instance, index );
+
+	if ( weights )
+	{
+		grasp.weights( *weights );
+	}
+}
+
+// Seed the random number generators with the full 64 bits, the parallel
+// runs drawing a 64-bit seed per try
+inline void scp_driver::seed( uint64_t s )
+{
+	grasp.rng.seed( s );
+	reactive_alpha.rng.seed( ~s );
+}
+
+inline void scp_driver::start()
+{
+	_x.clear();
+	_min_gap = std::numeric_limits<double>::infinity();
+	_max_gap = 0;
+	_sum_gap = 0;
+	_elapsed = 0;
+
+	grasp.alpha = alpha;
+	grasp.epsilon = epsilon;
+	local_search.stop = &stop;
+	stop.epsilon = _epsilon();
+	stop.start();
+	reactive_alpha.reset();
+}
+
+inline bool scp_driver::done() const
+{
+	return stop.done();
+}
+
+// One GRASP + local search iteration, throws std::runtime_error on failure
+inline void scp_driver::iterate()
+{
+	double z_g = 0, z_ls = 0;
+	bool verifying = verify > 0 && stop.iterations() % verify == 0;
+	int a = 0;
+
+	// Select the RCL threshold parameter
+
+	if ( reactive )
+	{
+		a = reactive_alpha.select();
+		grasp.alpha = reactive_alpha.alpha( a );
+	}
+
+	// Generate a solution using GRASP
+
+	if ( !grasp.run() )
+	{
+		throw std::runtime_error( "GRASP fail" );
+	}
+
+	z_g = grasp.z();
+
+	if ( !grasp.feasible() || ( verifying && !_check( grasp.x(), z_g ) ) )
+	{
+		throw std::runtime_error( "GRASP check fail" );
+	}
+
+	// Hand the solution over to the local search, without copy
+	local_search.x().swap( grasp.x() );
+
+	// Find a better solution using a local search
+
+	if ( !local_search.run() )
+	{
+		throw std::runtime_error( "Local search fail" );
+	}
+
+	const scp_solution & x = local_search.x();
+	z_ls = local_search.z();
+
+	if ( !local_search.feasible() || ( verifying && !_check( x, z_ls ) ) )
+	{
+		throw std::runtime_error( "Local search check fail" );
+	}
+
+	if ( reactive )
+	{
+		reactive_alpha.update( a, z_ls );
+	}
+
+	_record( grasp.alpha, z_g, z_ls, x );
+}
+
+// Record the last try of a copy of the driver, run by another thread
+inline void scp_driver::merge( const scp_driver & driver )
+{
+	_record( driver.grasp.alpha, driver.grasp.z(), driver.local_search.z(), driver.local_search.x() );
+}
+
+inline void scp_driver::run()
+{
+	start();
+
+	while ( !done() )
+	{
+		iterate();
+	}
+}
+
+// Offer a solution found elsewhere, such as by another island, return true
+// if it improves the best one. It does not count as an iteration
+inline bool scp_driver::migrate( double z, const scp_solution & x )
+{
+	// Always checked, whatever verify, since a slot of the ring may have
+	// been written by two islands at once (see <scp_island>)
+	if ( !_check( x, z ) )
+	{
+		return false;
+	}
+
+	if ( !stop.improve( z ) )
+	{
+		return false;
+	}
+
+	_x = x;
+
+	if ( incumbents )
+	{
+		_write_incumbent( stop.elapsed(), z, x );
+	}
+	return true;
+}
+
+// Instance and index given to read()
+inline const scp_problem & scp_driver::instance() const
+{
+	return *_instance;
+}
+
+inline const scp_index & scp_driver::index() const
+{
+	return *_index;
+}
+
+// Best objective value found
+inline double scp_driver::z() const
+{
+	return stop.best();
+}
+
+// Best solution found
+inline const scp_solution & scp_driver::x() const
+{
+	return _x;
+}
+
+inline int scp_driver::iterations() const
+{
+	return stop.iterations();
+}
+
+inline double scp_driver::elapsed() const
+{
+	return _elapsed;
+}
+
+// Approximate number of bytes used by the solvers and the index, without
+// the instance and a shared index
+inline std::size_t scp_driver::memory() const
+{
+	return sizeof( *this )
+	     - sizeof( grasp ) + grasp.memory()
+	     - sizeof( local_search ) + local_search.memory()
+	     - sizeof( _own_index ) + _own_index.memory()
+	     - sizeof( _x ) + _x.memory();
+}
+
+inline double scp_driver::min_gap() const
+{
+	return _min_gap;
+}
+
+inline double scp_driver::avg_gap() const
+{
+	return iterations() > 0 ? _sum_gap / double( iterations() ) : 0;
+}
+
+inline double scp_driver::max_gap() const
+{
+	return _max_gap;
+}
+
+// Tolerance of the comparisons of objective values
+inline double scp_driver::_epsilon() const
+{
+	return _integral ? 0 : epsilon;
+}
+
+// Full check of a solution: objective value, and coverage of each row
+inline bool scp_driver::_check( const scp_solution & x, double z ) const
+{
+	double diff = _instance->z( x ) - z;
+
+	if ( diff < -_epsilon() || diff > _epsilon() )
+	{
+		return false;
+	}
+
+	for ( int j = 0; j < _index->num_sets(); ++j )
+	{
+		const int * it = _index->S_begin( j );
+
+		while ( it != _index->S_end( j ) && !x.contains( *it ) ) ++it;
+
+		if ( it == _index->S_end( j ) ) return false;
+	}
+	return true;
+}
+
+// Line of the incumbents stream, flushed so that the solution survives if
+// the run is cut off
+inline void scp_driver::_write_incumbent( double t, double z, const scp_solution & x )
+{
+	std::streamsize precision = incumbents->precision( scp_precision );
+
+	*incumbents << t << ' ';
+	incumbents->precision( precision );
+
+	scp_write_solution( *incumbents, z, x, columns );
+	incumbents->flush();
+}
+
+// Statistics, streams and log of a try
+inline void scp_driver::_record( double alpha, double z_g, double z_ls, const scp_solution & x )
+{
+	double gap = 0;
+
+	_elapsed = stop.elapsed();
+
+	if ( pool )
+	{
+		scp_write_solution( *pool, z_ls, x, columns );
+	}
+
+	if ( stop.update( z_ls ) )
+	{
+		_x = x;
+
+		if ( incumbents )
+		{
+			_write_incumbent( _elapsed, z_ls, x );
+		}
+	}
+
+	gap = ( z_ls - z_ref ) / z_ref;
+
+	if ( gap < _min_gap ) _min_gap = gap;
+	if ( gap > _max_gap ) _max_gap = gap;
+	_sum_gap += gap;
+
+	// Display the results
+
+	if ( log )
+	{
+		*log << "[" << stop.iterations() << "] ";
+		if ( reactive )
+		{
+			*log << "alpha = " << alpha << " | ";
+		}
+		*log << "GRASP: " << z_g
+		     << " | GRASP+LS: " << z_ls
+		     << " | gap = " << 100. * gap << "%" << std::endl;
+	}
+}
+
+#endif
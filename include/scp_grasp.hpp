@@ -16,177 +16,57 @@
 #ifndef SCP_GRASP_HPP
 #define SCP_GRASP_HPP
 
-#include <vector>
-#include <set>
-#include <limits>
-#include <cstdlib>
-#include "scp_problem.hpp"
+#include "scp_greedy.hpp"
+#include "scp_profile.hpp"
 
 /*
 	Class: scp_grasp
 
 	Set Cover Problem solver using GRASP metaheuristic.
+
+	The construction is that of <scp_greedy>, from an empty solution. The
+	solution is sorted at the end of a run, and can be handed over to
+	another solver with swap().
 */
-struct scp_grasp
+struct scp_grasp : scp_greedy
 {
 	scp_grasp( double a = 0.9, double eps = 1e-9 );
 
-	void read( const scp_problem & instance );
-	void read( const std::vector<double> & c );
 	bool run();
 
-	double z() const;
-	std::set<int> x() const;
-
-	double alpha,
-	       epsilon;
-
-private:
-	std::vector<double> _c;
-	std::vector< std::set<int> > _S, _T;
-	std::set<int> _x;
-	double _z;
-
-	int _add( int i, std::vector<int> & u, std::vector<int> & v );
+	friend struct scp_bench;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
 
 inline scp_grasp::scp_grasp( double a, double eps ) :
-	alpha( a ), epsilon( eps ), _z( 0 )
+	scp_greedy( a, eps )
 {
 }
 
-inline void scp_grasp::read( const scp_problem & instance )
-{
-	int m = instance.num_elements(),
-	    n = instance.num_sets();
-
-	std::set<int>::const_iterator it;
-
-	_c.clear();
-	_S.clear();
-	_T.clear();
-
-	_c = instance.c;
-	_S = instance.S;
-	_T.resize( m, std::set<int>() );
-
-	for ( int j = 0; j < n; ++j )
-	{
-		for ( it = instance.S[j].begin(); it != instance.S[j].end(); ++it )
-		{
-			_T[*it].insert( j );
-		}
-	}
-}
-
-inline void scp_grasp::read( const std::vector<double> & c )
-{
-	_c = c;
-}
-
 inline bool scp_grasp::run()
 {
-	int m = _T.size(),
-	    n = _S.size();
-
-	std::vector<int> u( m, 0 ), v( n, 0 );
-	int num_covered = 0;
-	double c_min = std::numeric_limits<double>::infinity();
+	SCP_PROFILE_TIMER( grasp_run );
+	SCP_PROFILE_COUNT( grasp_runs );
 
-	_z = 0;
+	_reset();
 	_x.clear();
 
-	for ( int i = 0; i < m; ++i )
+	while ( _uncovered > 0 )
 	{
-		u[i] = _T[i].size();
+		int k = 0, num_candidates = 0;
 
-		// Cope with negative of null costs
-		if ( _c[i] < c_min )
-		{
-			c_min = _c[i];
-		}
-	}
+		if ( !_select( k, num_candidates ) ) return false;
 
-	while ( num_covered < n )
-	{
-		std::vector<double> e( m, 0 );
-		std::vector<int> rcl;
-		double e_min = 0, e_max = 0, e_limit = 0;
-		int k;
-
-		rcl.reserve( m );
-
-		for ( int i = 0; i < m; ++i )
-		{
-			if ( u[i] > 0 )
-			{
-				e[i] = double( u[i] ) / ( 1 + _c[i] - c_min );
-
-				if ( i > 0 )
-				{
-					if ( e[i] < e_min ) e_min = e[i];
-					if ( e[i] > e_max ) e_max = e[i];
-				}
-				else
-				{
-					e_min = e_max = e[i];
-				}
-			}
-		}
-
-		e_limit = e_min + alpha * ( e_max - e_min );
-
-		for ( int i = 0; i < m; ++i )
-		{
-			if ( u[i] > 0 && e[i] + epsilon >= e_limit )
-			{
-				rcl.push_back( i );
-			}
-		}
-
-		// Infeasible problem?
-		if ( rcl.empty() ) return false;
-
-		k = rcl[std::rand() % rcl.size()];
-		num_covered += _add( k, u, v );
-	}
-	return true;
-}
+		SCP_PROFILE_COUNT( grasp_steps );
+		SCP_PROFILE_ADD( grasp_scanned, _unicost ? 0 : _index->num_elements() );
+		SCP_PROFILE_ADD( grasp_candidates, num_candidates );
 
-inline double scp_grasp::z() const
-{
-	return _z;
-}
-
-inline std::set<int> scp_grasp::x() const
-{
-	return _x;
-}
-
-inline int scp_grasp::_add( int i, std::vector<int> & u, std::vector<int> & v )
-{
-	std::set<int>::const_iterator it, jt;
-	int n = 0;
-
-	_x.insert( i );
-	_z += _c[i];
-
-	for ( jt = _T[i].begin(); jt != _T[i].end(); ++jt )
-	{
-		if ( v[*jt] == 0 )
-		{
-			++n;
-
-			for ( it = _S[*jt].begin(); it != _S[*jt].end(); ++it )
-			{
-				--u[*it];
-			}
-		}
-		++v[*jt];
+		_uncovered -= _add( k );
 	}
-	return n;
+
+	_x.sort();
+	return true;
 }
 
 #endif
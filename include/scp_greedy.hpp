@@ -0,0 +1,338 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCP_GREEDY_HPP
+#define SCP_GREEDY_HPP
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include "scp_problem.hpp"
+#include "scp_solution.hpp"
+#include "scp_index.hpp"
+#include "scp_costs.hpp"
+#include "scp_random.hpp"
+#include "scp_score.hpp"
+#include "scp_buckets.hpp"
+#include "scp_memory.hpp"
+
+/*
+	Class: scp_greedy
+
+	Randomized greedy construction shared by <scp_grasp> and <scp_repair>:
+	each step draws a column from the restricted candidate list, and adds
+	it to the solution.
+
+	The working arrays are allocated by read() and reused by each run, so
+	that a step does not allocate memory.
+
+	On unicost instances, the efficiency of a column is its number of
+	uncovered rows: the columns are kept in a <scp_buckets> queue, the RCL
+	being the range of the buckets above the threshold, so that a step
+	needs no scan and no floating-point scoring.
+
+	The columns can also be scored by other weights than their costs (see
+	<weights>), the objective value being still that of the costs.
+*/
+struct scp_greedy
+{
+	scp_greedy( double a, double eps );
+
+	void read( const scp_problem & instance );
+	void read( const scp_problem & instance, const scp_index & index );
+	void read( const std::vector<double> & c );
+	void weights( const std::vector<double> & w );
+
+	double z() const;
+	bool feasible() const;
+	const scp_solution & x() const;
+	scp_solution & x();
+
+	std::size_t memory() const;
+
+	double alpha,
+	       epsilon;
+
+	scp_random rng;
+
+protected:
+	scp_costs _c;
+	scp_index _own_index;
+	const scp_index * _index;
+	scp_solution _x;
+	double _z;
+	int _uncovered;
+	bool _unicost;
+
+	// Scoring kernel, and workspaces: uncovered rows of each column,
+	// coverage of each row, rows covered since the last reset and
+	// restricted candidate list. On unicost instances, the uncovered
+	// rows are kept in the buckets instead
+	scp_score _score;
+	scp_buckets _buckets;
+	std::vector<int> _u, _covered, _rcl;
+	std::vector< int, scp_allocator<int> > _v;
+
+	void _reset();
+	bool _select( int & k, int & num_candidates );
+	int _add( int i );
+
+	template <class R, bool Unicost, int Degree>
+	int _add( int i );
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline scp_greedy::scp_greedy( double a, double eps ) :
+	alpha( a ), epsilon( eps ), _index( 0 ), _z( 0 ), _uncovered( 0 ), _unicost( false )
+{
+}
+
+inline void scp_greedy::read( const scp_problem & instance )
+{
+	_own_index.build( instance );
+	read( instance, _own_index );
+}
+
+// Share an index of the instance, which must outlive the solver
+inline void scp_greedy::read( const scp_problem & instance, const scp_index & index )
+{
+	int m = index.num_elements(),
+	    n = index.num_sets();
+
+	_index = &index;
+	_u.assign( m, 0 );
+	read( instance.c );
+
+	_v.assign( n, 0 );
+	_covered.clear();
+	_covered.reserve( n );
+	_rcl.assign( m + scp_score::padding, 0 );
+	_x.resize( m );
+}
+
+inline void scp_greedy::read( const std::vector<double> & c )
+{
+	_c.assign( c );
+	_score.read( c );
+	_unicost = scp_unicost( c );
+
+	// All the rows of each column are uncovered, also in the initial
+	// buckets
+	if ( _index )
+	{
+		for ( int i = 0; i < _index->num_elements(); ++i )
+		{
+			_u[i] = _index->T_size( i );
+		}
+
+		if ( _unicost ) _buckets.build( _u );
+	}
+}
+
+// Score the columns by the given weights in place of their costs, such
+// as their reduced costs, until the next read()
+inline void scp_greedy::weights( const std::vector<double> & w )
+{
+	_score.read( w );
+	_unicost = _unicost && scp_unicost( w );
+}
+
+inline double scp_greedy::z() const
+{
+	return _z;
+}
+
+// Whether the last run covered all the rows, kept up to date by _add
+inline bool scp_greedy::feasible() const
+{
+	return _uncovered == 0;
+}
+
+inline const scp_solution & scp_greedy::x() const
+{
+	return _x;
+}
+
+inline scp_solution & scp_greedy::x()
+{
+	return _x;
+}
+
+// Approximate number of bytes used, without a shared index
+inline std::size_t scp_greedy::memory() const
+{
+	return sizeof( *this ) - sizeof( _own_index ) + _own_index.memory()
+	     - sizeof( _c ) + _c.memory()
+	     - sizeof( _score ) + _score.memory()
+	     - sizeof( _buckets ) + _buckets.memory()
+	     - sizeof( _x ) + _x.memory()
+	     + ( _u.capacity() + _v.capacity() + _covered.capacity() + _rcl.capacity() ) * sizeof( int );
+}
+
+// Empty coverage, the solution being left to the caller. Only the rows
+// covered since the last reset and their columns are restored, unless
+// they are most of the rows, as after a cover, in which case the whole
+// arrays are
+inline void scp_greedy::_reset()
+{
+	int m = _index->num_elements(),
+	    n = _index->num_sets();
+	bool most = ( 2 * _covered.size() > std::size_t( n ) );
+
+	if ( _unicost )
+	{
+		_buckets.reset();
+	}
+	else if ( most )
+	{
+		for ( int i = 0; i < m; ++i )
+		{
+			_u[i] = _index->T_size( i );
+		}
+	}
+	else
+	{
+		for ( std::size_t p = 0; p < _covered.size(); ++p )
+		{
+			for ( const int * it = _index->S_begin( _covered[p] ); it != _index->S_end( _covered[p] ); ++it )
+			{
+				_u[*it] = _index->T_size( *it );
+			}
+		}
+	}
+
+	if ( most )
+	{
+		std::fill( _v.begin(), _v.end(), 0 );
+	}
+	else
+	{
+		for ( std::size_t p = 0; p < _covered.size(); ++p )
+		{
+			_v[_covered[p]] = 0;
+		}
+	}
+	_covered.clear();
+
+	_z = 0;
+	_uncovered = _index->num_sets();
+}
+
+// Draw a column of the RCL, return false if there is none (infeasible
+// problem, or alpha out of [0,1])
+inline bool scp_greedy::_select( int & k, int & num_candidates )
+{
+	if ( _unicost )
+	{
+		int u_min = _buckets.min_positive(),
+		    u_max = _buckets.max(),
+		    first;
+		double threshold;
+
+		if ( u_min == 0 ) return false;
+
+		// Smallest count above the threshold, the candidates being the
+		// columns from its bucket to the end. The threshold is clamped
+		// to the counts of the columns, the bucket of a key out of them
+		// being out of range
+		threshold = std::ceil( u_min + alpha * ( u_max - u_min ) - epsilon );
+		first = _buckets.start( int( std::max( double( u_min ), std::min( threshold, double( u_max ) ) ) ) );
+		num_candidates = _buckets.size() - first;
+
+		if ( num_candidates == 0 ) return false;
+
+		k = _buckets[first + rng( num_candidates )];
+	}
+	else
+	{
+		double e_min = 0, e_max = 0;
+
+		if ( !_score.minmax( _u, e_min, e_max ) ) return false;
+
+		num_candidates = _score.select( _u, e_min + alpha * ( e_max - e_min ) - epsilon, _rcl );
+
+		// The candidates of the pure greedy choice are those within the
+		// tolerance of the best one, of which only the best are kept when
+		// they can be compared exactly
+		if ( alpha == 1 )
+		{
+			num_candidates = _score.exact_max( _u, _rcl, num_candidates );
+		}
+
+		if ( num_candidates == 0 ) return false;
+
+		k = _rcl[rng( num_candidates )];
+	}
+	return true;
+}
+
+// Add a column to the solution, or only to the coverage if it is already
+// in it, and return the number of rows it newly covers
+inline int scp_greedy::_add( int i )
+{
+	bool triples = ( _index->degree() == 3 );
+
+	// Width of the row indices, cost policy and fixed degree of the rows
+	if ( _index->compact() )
+	{
+		if ( _unicost ) return triples ? _add<uint16_t, true, 3>( i ) : _add<uint16_t, true, 0>( i );
+		return triples ? _add<uint16_t, false, 3>( i ) : _add<uint16_t, false, 0>( i );
+	}
+	if ( _unicost ) return triples ? _add<int, true, 3>( i ) : _add<int, true, 0>( i );
+	return triples ? _add<int, false, 3>( i ) : _add<int, false, 0>( i );
+}
+
+// With Degree > 0, every row has Degree columns, and the loop over them
+// has a constant trip count
+template <class R, bool Unicost, int Degree>
+inline int scp_greedy::_add( int i )
+{
+	std::vector<int> & u = _u;
+	std::vector< int, scp_allocator<int> > & v = _v;
+	int n = 0;
+
+	_x.insert( i );
+	_z += _c[i];
+
+	for ( const R * jt = _index->T_begin<R>( i ); jt != _index->T_end<R>( i ); ++jt )
+	{
+		if ( v[*jt] == 0 )
+		{
+			++n;
+			_covered.push_back( *jt );
+
+			const int * it = _index->S_begin( *jt ),
+			          * it_end = ( Degree > 0 ? it + Degree : _index->S_end( *jt ) );
+
+			for ( ; it != it_end; ++it )
+			{
+				if ( Unicost )
+				{
+					_buckets.decrement( *it );
+				}
+				else
+				{
+					--u[*it];
+				}
+			}
+		}
+		++v[*jt];
+	}
+	return n;
+}
+
+#endif
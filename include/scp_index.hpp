@@ -0,0 +1,569 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCP_INDEX_HPP
+#define SCP_INDEX_HPP
+
+#include <pthread.h>
+#include <unistd.h>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <stdint.h>
+#include "scp_problem.hpp"
+#include "scp_memory.hpp"
+
+/*
+	Class: scp_index
+
+	Compressed index of an instance: the elements of each set (rows, CSR)
+	and the sets containing each element (columns, CSC), both sorted.
+
+	When there are at most 65536 sets, the sets containing each element are
+	stored on 16 bits (see <compact>), and the solvers select the width
+	with the template accessors T_begin<R> and T_end<R>.
+
+	When all the sets have the same number of elements (see <degree>), as
+	the 3 of the Steiner triple instances, the solvers can unroll the loops
+	over the elements of a set.
+
+	It is built once per instance, by a parallel counting sort (count,
+	prefix sum, scatter), and can be shared by all the solvers since it is
+	not modified afterwards. It can also be written to a flat buffer (see
+	<write>) and used in place by other processes (see <attach>), for
+	instance from shared memory.
+
+	Its arrays are allocated by <scp_memory>, on huge pages if selected.
+*/
+struct scp_index
+{
+	scp_index();
+	scp_index( const scp_problem & instance, int num_threads = 0 );
+	scp_index( const scp_index & index );
+	scp_index & operator=( const scp_index & index );
+
+	void build( const scp_problem & instance, int num_threads = 0 );
+	void copy( const scp_index & index );
+	void clear();
+
+	std::size_t size() const;
+	void write( void * data ) const;
+	bool attach( const void * data );
+	bool attached() const;
+
+	int num_elements() const;
+	int num_sets() const;
+	int num_nonzeros() const;
+	bool compact() const;
+	int degree() const;
+
+	std::size_t memory() const;
+
+	// Elements of the set j
+	const int * S_begin( int j ) const;
+	const int * S_end( int j ) const;
+	int S_size( int j ) const;
+
+	// Sets containing the element i, R being uint16_t if compact, else int
+	template <class R> const R * T_begin( int i ) const;
+	template <class R> const R * T_end( int i ) const;
+	int T_size( int i ) const;
+
+private:
+	std::vector< int, scp_allocator<int> > _S_start, _S_index,
+	                                      _T_start, _T_index;
+	std::vector< uint16_t, scp_allocator<uint16_t> > _T_index16;
+	bool _compact;
+	int _degree;
+
+	// Arrays read by the accessors: the vectors above, or a buffer written
+	// by another index
+	int _m, _n;
+	const int * _S_start_p, * _S_index_p,
+	          * _T_start_p, * _T_index_p;
+	const uint16_t * _T_index16_p;
+	bool _attached;
+
+	// Header of the flat buffer, followed by the arrays, each one padded to
+	// a multiple of 8 bytes
+	struct header
+	{
+		char magic[8];
+		int32_t m, n, nnz, compact, degree, reserved;
+	};
+
+	void _point();
+	static std::size_t _padded( std::size_t size );
+
+	// Per-thread task of the parallel build
+	struct task
+	{
+		scp_index * index;
+		const scp_problem * instance;
+		pthread_barrier_t * barrier;
+		std::vector< std::vector<int> > * counts;
+		int thread, num_threads;
+	};
+
+	static void * _run( void * t );
+	void _build( const task & t );
+
+	template <class R>
+	void _scatter( const task & t, R * T_index );
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline scp_index::scp_index() :
+	_compact( false ), _degree( 0 )
+{
+	clear();
+}
+
+inline scp_index::scp_index( const scp_problem & instance, int num_threads ) :
+	_compact( false ), _degree( 0 )
+{
+	build( instance, num_threads );
+}
+
+inline scp_index::scp_index( const scp_index & index )
+{
+	*this = index;
+}
+
+// The copy of an attached index reads the same buffer
+inline scp_index & scp_index::operator=( const scp_index & index )
+{
+	if ( this != &index )
+	{
+		_S_start = index._S_start;
+		_S_index = index._S_index;
+		_T_start = index._T_start;
+		_T_index = index._T_index;
+		_T_index16 = index._T_index16;
+		_compact = index._compact;
+		_degree = index._degree;
+		_m = index._m;
+		_n = index._n;
+		_S_start_p = index._S_start_p;
+		_S_index_p = index._S_index_p;
+		_T_start_p = index._T_start_p;
+		_T_index_p = index._T_index_p;
+		_T_index16_p = index._T_index16_p;
+		_attached = index._attached;
+
+		if ( !_attached && !_S_start.empty() )
+		{
+			_point();
+		}
+	}
+	return *this;
+}
+
+// Copy the arrays of an index, also attached, into memory owned by this
+// one and first touched by the calling thread, as a NUMA replica
+inline void scp_index::copy( const scp_index & index )
+{
+	int nnz = index.num_nonzeros();
+
+	if ( this == &index ) return;
+
+	clear();
+
+	if ( index._S_start_p == 0 ) return;
+
+	_S_start.assign( index._S_start_p, index._S_start_p + index._n + 1 );
+	_S_index.assign( index._S_index_p, index._S_index_p + nnz + 1 );
+	_T_start.assign( index._T_start_p, index._T_start_p + index._m + 1 );
+
+	if ( index._compact )
+	{
+		_T_index16.assign( index._T_index16_p, index._T_index16_p + nnz + 1 );
+	}
+	else
+	{
+		_T_index.assign( index._T_index_p, index._T_index_p + nnz + 1 );
+	}
+
+	_compact = index._compact;
+	_degree = index._degree;
+	_m = index._m;
+	_n = index._n;
+	_point();
+}
+
+// With num_threads = 0, one thread per online processor
+inline void scp_index::build( const scp_problem & instance, int num_threads )
+{
+	int m = instance.num_elements(),
+	    n = instance.num_sets(),
+	    nnz = 0;
+
+	clear();
+
+	_S_start.resize( n + 1, 0 );
+	_T_start.resize( m + 1, 0 );
+
+	_degree = ( n > 0 ? instance.S[0].size() : 0 );
+
+	for ( int j = 0; j < n; ++j )
+	{
+		_S_start[j+1] = nnz += instance.S[j].size();
+
+		if ( int( instance.S[j].size() ) != _degree ) _degree = 0;
+	}
+
+	// One more element, so that the pointers are valid even without
+	// nonzeros
+	_compact = ( n <= 65536 );
+	_S_index.resize( nnz + 1 );
+
+	if ( _compact )
+	{
+		_T_index16.resize( nnz + 1 );
+	}
+	else
+	{
+		_T_index.resize( nnz + 1 );
+	}
+
+	_m = m;
+	_n = n;
+	_point();
+
+	if ( num_threads <= 0 )
+	{
+		num_threads = sysconf( _SC_NPROCESSORS_ONLN );
+	}
+
+	// Threads are not worth it on small instances, and each one needs an
+	// array of m counters, whose total is kept within the nonzeros so
+	// that the transient memory is at most that of the index
+	if ( num_threads > nnz / 65536 ) num_threads = nnz / 65536;
+	if ( m > 0 && num_threads > nnz / m ) num_threads = nnz / m;
+	if ( num_threads > n ) num_threads = n;
+	if ( num_threads < 1 ) num_threads = 1;
+
+	std::vector< std::vector<int> > counts( num_threads, std::vector<int>( m, 0 ) );
+	std::vector<pthread_t> threads( num_threads );
+	std::vector<task> tasks( num_threads );
+	pthread_barrier_t barrier;
+
+	pthread_barrier_init( &barrier, 0, num_threads );
+
+	for ( int t = 0; t < num_threads; ++t )
+	{
+		tasks[t].index = this;
+		tasks[t].instance = &instance;
+		tasks[t].barrier = &barrier;
+		tasks[t].counts = &counts;
+		tasks[t].thread = t;
+		tasks[t].num_threads = num_threads;
+	}
+
+	for ( int t = 1; t < num_threads; ++t )
+	{
+		pthread_create( &threads[t], 0, _run, &tasks[t] );
+	}
+
+	_build( tasks[0] );
+
+	for ( int t = 1; t < num_threads; ++t )
+	{
+		pthread_join( threads[t], 0 );
+	}
+
+	pthread_barrier_destroy( &barrier );
+}
+
+inline void scp_index::clear()
+{
+	_S_start.clear();
+	_S_index.clear();
+	_T_start.clear();
+	_T_index.clear();
+	_T_index16.clear();
+	_compact = false;
+	_degree = 0;
+
+	_m = _n = 0;
+	_S_start_p = _S_index_p = _T_start_p = _T_index_p = 0;
+	_T_index16_p = 0;
+	_attached = false;
+}
+
+// Number of bytes of the flat buffer
+inline std::size_t scp_index::size() const
+{
+	int nnz = num_nonzeros();
+
+	return sizeof( header )
+	     + _padded( ( _n + 1 + nnz + 1 + _m + 1 ) * sizeof( int ) )
+	     + _padded( ( nnz + 1 ) * ( _compact ? sizeof( uint16_t ) : sizeof( int ) ) );
+}
+
+// Write the index to a buffer of size() bytes, aligned on 8 bytes
+inline void scp_index::write( void * data ) const
+{
+	header * h = static_cast<header *>( data );
+	int * p = reinterpret_cast<int *>( h + 1 );
+	int nnz = num_nonzeros();
+
+	std::memset( h, 0, sizeof( header ) );
+	std::memcpy( h->magic, "SCPINDEX", 8 );
+	h->m = _m;
+	h->n = _n;
+	h->nnz = nnz;
+	h->compact = _compact;
+	h->degree = _degree;
+
+	p = std::copy( _S_start_p, _S_start_p + _n + 1, p );
+	p = std::copy( _S_index_p, _S_index_p + nnz + 1, p );
+	p = std::copy( _T_start_p, _T_start_p + _m + 1, p );
+	p = reinterpret_cast<int *>( h + 1 ) + _padded( ( _n + 1 + nnz + 1 + _m + 1 ) * sizeof( int ) ) / sizeof( int );
+
+	if ( _compact )
+	{
+		std::copy( _T_index16_p, _T_index16_p + nnz + 1, reinterpret_cast<uint16_t *>( p ) );
+	}
+	else
+	{
+		std::copy( _T_index_p, _T_index_p + nnz + 1, p );
+	}
+}
+
+// Use in place a buffer filled by write(), which must outlive the index,
+// return false if it is not an index
+inline bool scp_index::attach( const void * data )
+{
+	const header * h = static_cast<const header *>( data );
+	const int * p = reinterpret_cast<const int *>( h + 1 );
+
+	clear();
+
+	if ( std::memcmp( h->magic, "SCPINDEX", 8 ) != 0 ) return false;
+
+	_m = h->m;
+	_n = h->n;
+	_compact = h->compact;
+	_degree = h->degree;
+
+	_S_start_p = p;
+	_S_index_p = _S_start_p + _n + 1;
+	_T_start_p = _S_index_p + h->nnz + 1;
+	p += _padded( ( _n + 1 + h->nnz + 1 + _m + 1 ) * sizeof( int ) ) / sizeof( int );
+
+	if ( _compact )
+	{
+		_T_index16_p = reinterpret_cast<const uint16_t *>( p );
+	}
+	else
+	{
+		_T_index_p = p;
+	}
+
+	_attached = true;
+	return true;
+}
+
+// Whether the arrays are in a buffer of another index
+inline bool scp_index::attached() const
+{
+	return _attached;
+}
+
+inline int scp_index::num_elements() const
+{
+	return _m;
+}
+
+inline int scp_index::num_sets() const
+{
+	return _n;
+}
+
+inline int scp_index::num_nonzeros() const
+{
+	return _S_start_p ? _S_start_p[_n] : 0;
+}
+
+// Whether the sets containing each element are stored on 16 bits
+inline bool scp_index::compact() const
+{
+	return _compact;
+}
+
+// Number of elements of every set, or 0 if they differ
+inline int scp_index::degree() const
+{
+	return _degree;
+}
+
+// Number of bytes used
+inline std::size_t scp_index::memory() const
+{
+	return sizeof( *this )
+	     + ( _S_start.capacity() + _S_index.capacity()
+	       + _T_start.capacity() + _T_index.capacity() ) * sizeof( int )
+	     + _T_index16.capacity() * sizeof( uint16_t );
+}
+
+inline const int * scp_index::S_begin( int j ) const
+{
+	return _S_index_p + _S_start_p[j];
+}
+
+inline const int * scp_index::S_end( int j ) const
+{
+	return _S_index_p + _S_start_p[j+1];
+}
+
+inline int scp_index::S_size( int j ) const
+{
+	return _S_start_p[j+1] - _S_start_p[j];
+}
+
+template <>
+inline const int * scp_index::T_begin<int>( int i ) const
+{
+	return _T_index_p + _T_start_p[i];
+}
+
+template <>
+inline const int * scp_index::T_end<int>( int i ) const
+{
+	return _T_index_p + _T_start_p[i+1];
+}
+
+template <>
+inline const uint16_t * scp_index::T_begin<uint16_t>( int i ) const
+{
+	return _T_index16_p + _T_start_p[i];
+}
+
+template <>
+inline const uint16_t * scp_index::T_end<uint16_t>( int i ) const
+{
+	return _T_index16_p + _T_start_p[i+1];
+}
+
+inline int scp_index::T_size( int i ) const
+{
+	return _T_start_p[i+1] - _T_start_p[i];
+}
+
+// Arrays of the vectors
+inline void scp_index::_point()
+{
+	_S_start_p = &_S_start[0];
+	_S_index_p = &_S_index[0];
+	_T_start_p = &_T_start[0];
+	_T_index_p = _T_index.empty() ? 0 : &_T_index[0];
+	_T_index16_p = _T_index16.empty() ? 0 : &_T_index16[0];
+	_attached = false;
+}
+
+inline std::size_t scp_index::_padded( std::size_t size )
+{
+	return ( size + 7 ) / 8 * 8;
+}
+
+inline void * scp_index::_run( void * t )
+{
+	const task & self = *static_cast<task *>( t );
+	self.index->_build( self );
+	return 0;
+}
+
+inline void scp_index::_build( const task & t )
+{
+	const scp_problem & instance = *t.instance;
+	std::vector<int> & count = ( *t.counts )[t.thread];
+	int m = instance.num_elements(),
+	    n = instance.num_sets(),
+	    j_first = (long) n * t.thread / t.num_threads,
+	    j_last = (long) n * ( t.thread + 1 ) / t.num_threads,
+	    i_first = (long) m * t.thread / t.num_threads,
+	    i_last = (long) m * ( t.thread + 1 ) / t.num_threads;
+
+	// Copy the rows of the thread and count their elements
+	for ( int j = j_first; j < j_last; ++j )
+	{
+		int * p = &_S_index[0] + _S_start[j];
+
+		for ( std::size_t k = 0; k < instance.S[j].size(); ++k )
+		{
+			*p++ = instance.S[j][k];
+			++count[instance.S[j][k]];
+		}
+	}
+
+	pthread_barrier_wait( t.barrier );
+
+	// Offset of each thread in the column, and size of the column
+	for ( int i = i_first; i < i_last; ++i )
+	{
+		int size = 0;
+
+		for ( int k = 0; k < t.num_threads; ++k )
+		{
+			int c = ( *t.counts )[k][i];
+			( *t.counts )[k][i] = size;
+			size += c;
+		}
+		_T_start[i+1] = size;
+	}
+
+	pthread_barrier_wait( t.barrier );
+
+	if ( t.thread == 0 )
+	{
+		for ( int i = 0; i < m; ++i )
+		{
+			_T_start[i+1] += _T_start[i];
+		}
+	}
+
+	pthread_barrier_wait( t.barrier );
+
+	if ( _compact )
+	{
+		_scatter( t, &_T_index16[0] );
+	}
+	else
+	{
+		_scatter( t, &_T_index[0] );
+	}
+}
+
+// Scatter: the rows are visited in order, so the columns are sorted
+template <class R>
+inline void scp_index::_scatter( const task & t, R * T_index )
+{
+	std::vector<int> & count = ( *t.counts )[t.thread];
+	int n = t.instance->num_sets(),
+	    j_first = (long) n * t.thread / t.num_threads,
+	    j_last = (long) n * ( t.thread + 1 ) / t.num_threads;
+
+	for ( int j = j_first; j < j_last; ++j )
+	{
+		for ( const int * p = S_begin( j ); p != S_end( j ); ++p )
+		{
+			T_index[_T_start[*p] + count[*p]++] = j;
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,264 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCP_IO_HPP
+#define SCP_IO_HPP
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "scp_problem.hpp"
+#include "gzfstream.hpp"
+
+/*
+	Instance file formats and loading.
+*/
+enum scp_format
+{
+	format_scp,
+	format_rail,
+	format_stn,
+	format_binary
+};
+
+bool scp_format_parse( const std::string & s, scp_format & format );
+const char * scp_format_name( scp_format format );
+
+bool scp_read( scp_format format, std::istream & is, scp_problem & instance );
+bool scp_load( const std::string & filename, scp_format format, scp_problem & instance );
+
+bool scp_save( const std::string & filename, const scp_problem & instance, int level = -1 );
+
+void scp_write_solution( std::ostream & os, double z, const scp_solution & x, const std::vector<int> * columns = 0 );
+
+// Significant digits of the values in the machine-readable outputs, with
+// which a double is read back exactly
+const int scp_precision = 17;
+
+/*
+	Class: scp_ofstream
+
+	Output file stream, gzip compressed with the given level if the name
+	ends with .gz, or the standard output if the name is "-".
+*/
+struct scp_ofstream : std::ostream
+{
+	scp_ofstream();
+	~scp_ofstream();
+
+	bool open( const std::string & filename, int level = -1 );
+	bool is_open() const;
+	bool close();
+
+private:
+	gz::filebuf _gz;
+	std::filebuf _file;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline bool scp_format_parse( const std::string & s, scp_format & format )
+{
+	if ( s == "scp" || s.empty() )
+	{
+		format = format_scp;
+	}
+	else if ( s == "rail" )
+	{
+		format = format_rail;
+	}
+	else if ( s == "stn" )
+	{
+		format = format_stn;
+	}
+	else if ( s == "binary" )
+	{
+		format = format_binary;
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
+inline const char * scp_format_name( scp_format format )
+{
+	switch ( format )
+	{
+		case format_rail:   return "rail";
+		case format_stn:    return "stn";
+		case format_binary: return "binary";
+		case format_scp:
+		default:            return "scp";
+	}
+}
+
+// Return false if the instance is truncated or invalid
+inline bool scp_read( scp_format format, std::istream & is, scp_problem & instance )
+{
+	switch ( format )
+	{
+		case format_rail:   return instance.read_rail( is );
+		case format_stn:    return instance.read_stn( is );
+		case format_binary: return instance.read_binary( is );
+		case format_scp:
+		default:            return instance.read( is );
+	};
+}
+
+// Load an instance from a file, gzip compressed if its name ends with .gz,
+// or from the standard input if the name is "-". Return false if the file
+// cannot be opened or read
+inline bool scp_load( const std::string & filename, scp_format format, scp_problem & instance )
+{
+	bool ok = false;
+
+	if ( filename.substr( filename.find_last_of( "." ) + 1 ) == "gz" )
+	{
+		// Read gzip compressed instance
+		gz::ifstream file( filename.c_str() );
+		if ( !file.is_open() )
+		{
+			return false;
+		}
+		ok = scp_read( format, file, instance );
+		file.close();
+	}
+	else if ( filename != "-" )
+	{
+		// Read uncompressed instance from file
+		std::ifstream file( filename.c_str(), std::ios::in | std::ios::binary );
+		if ( !file.is_open() )
+		{
+			return false;
+		}
+		ok = scp_read( format, file, instance );
+		file.close();
+	}
+	else
+	{
+		// Read uncompressed instance from terminal
+		ok = scp_read( format, std::cin, instance );
+	}
+	return ok;
+}
+
+// Save an instance, in the binary format if the name ends with .bin or
+// .bin.gz, and in the scp format otherwise
+inline bool scp_save( const std::string & filename, const scp_problem & instance, int level )
+{
+	scp_ofstream file;
+	std::string name = filename;
+
+	if ( !file.open( filename, level ) )
+	{
+		return false;
+	}
+
+	if ( name.substr( name.find_last_of( "." ) + 1 ) == "gz" )
+	{
+		name.erase( name.find_last_of( "." ) );
+	}
+
+	if ( name.substr( name.find_last_of( "." ) + 1 ) == "bin" )
+	{
+		instance.write_binary( file );
+	}
+	else
+	{
+		instance.write( file );
+	}
+
+	return file.close();
+}
+
+// Write a solution on one line: the objective value followed by the
+// columns, starting from 1, or their original numbers if the instance is
+// renumbered
+inline void scp_write_solution( std::ostream & os, double z, const scp_solution & x, const std::vector<int> * columns )
+{
+	scp_solution::const_iterator it;
+	std::streamsize precision = os.precision( scp_precision );
+
+	os << z;
+	for ( it = x.begin(); it != x.end(); ++it )
+	{
+		os << ' ' << ( columns ? ( *columns )[*it] : *it ) + 1;
+	}
+	os << '\n';
+
+	os.precision( precision );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline scp_ofstream::scp_ofstream() :
+	std::ostream( 0 )
+{
+}
+
+inline scp_ofstream::~scp_ofstream()
+{
+	close();
+}
+
+inline bool scp_ofstream::open( const std::string & filename, int level )
+{
+	close();
+
+	if ( filename.substr( filename.find_last_of( "." ) + 1 ) == "gz" )
+	{
+		if ( !_gz.open( filename.c_str(), std::ios::out, level ) ) return false;
+		rdbuf( &_gz );
+	}
+	else if ( filename != "-" )
+	{
+		if ( !_file.open( filename.c_str(), std::ios::out | std::ios::binary ) ) return false;
+		rdbuf( &_file );
+	}
+	else
+	{
+		rdbuf( std::cout.rdbuf() );
+	}
+	return true;
+}
+
+inline bool scp_ofstream::is_open() const
+{
+	return rdbuf() != 0;
+}
+
+// Returns false if some data could not be written
+inline bool scp_ofstream::close()
+{
+	bool ok;
+
+	if ( !is_open() )
+	{
+		return true;
+	}
+
+	ok = !flush().fail();
+
+	if ( _gz.is_open() && !_gz.close() ) ok = false;
+	if ( _file.is_open() && !_file.close() ) ok = false;
+
+	rdbuf( 0 );
+	return ok;
+}
+
+#endif
@@ -0,0 +1,471 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCP_ISLAND_HPP
+#define SCP_ISLAND_HPP
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cstring>
+#include <stdint.h>
+#include "scp_problem.hpp"
+#include "scp_solution.hpp"
+#include "scp_index.hpp"
+#include "scp_driver.hpp"
+#include "chrono.hpp"
+
+/*
+	Class: scp_island
+
+	Island model over several processes of a node, sharing a POSIX shared
+	memory segment of the given name.
+
+	The first process to claim the name (see <create>) loads the instance
+	and publishes its costs, its index and the reference objective value
+	(see <publish>), with the name and size of its file. The other ones
+	wait for it (see <attach>), check that it is their own instance (see
+	<holds>) and use the index in place, so that an island costs only its
+	solvers.
+
+	The islands exchange their best solutions through a ring of slots in
+	the segment, without lock: a writer takes a ticket by an atomic
+	increment, and marks its slot with a sequence number, odd while it
+	writes, so that a reader detects and skips a slot being overwritten.
+	A reader that falls more than a ring behind loses the oldest solutions.
+	Two writers a ring apart may still write the same slot at once, so
+	that the solutions received must be checked (see <scp_driver::migrate>).
+
+	The segment is removed by the last process to leave. A process killed
+	before leaving leaves it behind, in /dev/shm on Linux: the next
+	processes of the same name then wait for it in vain, or find another
+	instance, until it is removed (rm /dev/shm/NAME).
+*/
+struct scp_island
+{
+	enum { capacity = 64 };
+
+	scp_island();
+	~scp_island();
+
+	bool create( const std::string & name );
+	bool publish( const scp_problem & instance, const scp_index & index, double z_ref, const std::string & filename );
+	bool attach( const std::string & name, double timeout = 600 );
+	void leave();
+
+	bool joined() const;
+	bool holds( const std::string & filename ) const;
+	int id() const;
+	std::size_t size() const;
+
+	const scp_problem & instance() const;
+	const scp_index & index() const;
+	double z_ref() const;
+
+	bool send( double z, const scp_solution & x );
+	bool receive( double & z, scp_solution & x );
+	int exchange( scp_driver & driver );
+
+private:
+	struct header
+	{
+		char magic[8];
+		volatile int32_t ready, members, next_id;
+		int32_t m, n, slot_size;
+		double z_ref;
+		volatile uint64_t head;
+		uint64_t costs, index, ring, stride;
+
+		// Instance file, and its size
+		int64_t source_size;
+		char source[256];
+	};
+
+	struct slot
+	{
+		volatile uint64_t seq;
+		int32_t island, size;
+		double z;
+	};
+
+	std::string _name;
+	int _fd, _id;
+	void * _data;
+	std::size_t _size;
+	header * _header;
+	bool _created;
+	uint64_t _next;
+
+	// Costs only, and index in the segment
+	scp_problem _instance;
+	scp_index _index;
+
+	std::vector<int> _buffer;
+
+	// Best objective value sent, and solution received by exchange()
+	double _z_sent;
+	scp_solution _migrant;
+
+	void _read();
+	slot * _slot( uint64_t t ) const;
+
+	static std::size_t _padded( std::size_t size );
+	static int64_t _file_size( const std::string & filename );
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline scp_island::scp_island() :
+	_fd( -1 ), _id( -1 ), _data( 0 ), _size( 0 ), _header( 0 ), _created( false ), _next( 0 ),
+	_z_sent( std::numeric_limits<double>::infinity() )
+{
+}
+
+inline scp_island::~scp_island()
+{
+	leave();
+}
+
+// Claim the name, return false if another process has already done it
+inline bool scp_island::create( const std::string & name )
+{
+	leave();
+
+	_name = ( !name.empty() && name[0] == '/' ) ? name : "/" + name;
+	_fd = shm_open( _name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600 );
+	_created = ( _fd >= 0 );
+
+	return _created;
+}
+
+// Publish the instance read from the given file in the segment claimed by
+// create()
+inline bool scp_island::publish( const scp_problem & instance, const scp_index & index, double z_ref, const std::string & filename )
+{
+	int m = instance.num_elements(),
+	    n = instance.num_sets(),
+	    slot_size = std::min( m, n );
+	std::size_t costs = _padded( sizeof( header ) ),
+	            offset = costs + _padded( m * sizeof( double ) ),
+	            ring = offset + _padded( index.size() ),
+	            stride = _padded( sizeof( slot ) + slot_size * sizeof( int32_t ) );
+
+	if ( !_created || _header ) return false;
+
+	_size = ring + capacity * stride;
+
+	if ( ftruncate( _fd, _size ) != 0 ) return false;
+
+	_data = mmap( 0, _size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0 );
+	if ( _data == MAP_FAILED )
+	{
+		_data = 0;
+		return false;
+	}
+
+	// The sequence numbers of the slots are null, no ticket being taken
+	_header = static_cast<header *>( _data );
+	std::memcpy( _header->magic, "SCPISL2", 8 );
+	_header->members = 1;
+	_header->next_id = 1;
+	_header->m = m;
+	_header->n = n;
+	_header->slot_size = slot_size;
+	_header->z_ref = z_ref;
+	_header->head = 0;
+	_header->costs = costs;
+	_header->index = offset;
+	_header->ring = ring;
+	_header->stride = stride;
+	_header->source_size = _file_size( filename );
+	std::strncpy( _header->source, filename.c_str(), sizeof( _header->source ) - 1 );
+
+	std::copy( instance.c.begin(), instance.c.end(), reinterpret_cast<double *>( static_cast<char *>( _data ) + costs ) );
+	index.write( static_cast<char *>( _data ) + offset );
+
+	__sync_synchronize();
+	_header->ready = 1;
+
+	_id = 0;
+	_read();
+	return true;
+}
+
+// Join the island of the given name, waiting at most timeout seconds in
+// all for its instance to be claimed and published
+inline bool scp_island::attach( const std::string & name, double timeout )
+{
+	chrono::time_point begin = chrono::now();
+
+	leave();
+	_name = ( !name.empty() && name[0] == '/' ) ? name : "/" + name;
+
+	while ( chrono::now() - begin < timeout )
+	{
+		struct stat st;
+
+		_fd = shm_open( _name.c_str(), O_RDWR, 0600 );
+
+		if ( _fd >= 0 && fstat( _fd, &st ) == 0 && std::size_t( st.st_size ) >= sizeof( header ) )
+		{
+			_size = st.st_size;
+			_data = mmap( 0, _size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0 );
+
+			if ( _data != MAP_FAILED )
+			{
+				header * h = static_cast<header *>( _data );
+
+				if ( h->ready == 1 )
+				{
+					__sync_synchronize();
+
+					if ( std::memcmp( h->magic, "SCPISL2", 8 ) != 0 ) break;
+
+					_header = h;
+					_id = __sync_fetch_and_add( &_header->next_id, 1 );
+					__sync_fetch_and_add( &_header->members, 1 );
+					_read();
+					return true;
+				}
+				munmap( _data, _size );
+			}
+			_data = 0;
+		}
+
+		if ( _fd >= 0 ) close( _fd );
+		_fd = -1;
+
+		usleep( 10000 );
+	}
+
+	leave();
+	return false;
+}
+
+// Unmap the segment, and remove it if this process is the last one, or
+// the creator before publishing
+inline void scp_island::leave()
+{
+	bool last = _created && !_header;
+
+	if ( _header )
+	{
+		last = ( __sync_sub_and_fetch( &_header->members, 1 ) == 0 );
+	}
+
+	_index.clear();
+	_instance.clear();
+
+	if ( _data ) munmap( _data, _size );
+	if ( _fd >= 0 ) close( _fd );
+	if ( last ) shm_unlink( _name.c_str() );
+
+	_fd = -1;
+	_id = -1;
+	_data = 0;
+	_size = 0;
+	_header = 0;
+	_created = false;
+	_next = 0;
+}
+
+// Whether the instance is published, and the solutions can be exchanged
+inline bool scp_island::joined() const
+{
+	return _header != 0;
+}
+
+// Whether the instance was published from the given file, as far as its
+// name and size tell
+inline bool scp_island::holds( const std::string & filename ) const
+{
+	return _header
+	    && filename.compare( 0, sizeof( _header->source ) - 1, _header->source ) == 0
+	    && _file_size( filename ) == _header->source_size;
+}
+
+// Number of the island, 0 for its creator
+inline int scp_island::id() const
+{
+	return _id;
+}
+
+// Number of bytes of the segment
+inline std::size_t scp_island::size() const
+{
+	return _size;
+}
+
+// Instance holding only the costs, the rows being in index()
+inline const scp_problem & scp_island::instance() const
+{
+	return _instance;
+}
+
+inline const scp_index & scp_island::index() const
+{
+	return _index;
+}
+
+inline double scp_island::z_ref() const
+{
+	return _header ? _header->z_ref : 0;
+}
+
+// Send a solution to the other islands
+inline bool scp_island::send( double z, const scp_solution & x )
+{
+	uint64_t t;
+	slot * s;
+
+	if ( !_header || x.size() > _header->slot_size ) return false;
+
+	t = __sync_fetch_and_add( &_header->head, 1 );
+	s = _slot( t );
+
+	s->seq = 2 * t + 1;
+	__sync_synchronize();
+
+	s->island = _id;
+	s->size = x.size();
+	s->z = z;
+	std::copy( x.begin(), x.end(), reinterpret_cast<int32_t *>( s + 1 ) );
+
+	__sync_synchronize();
+	s->seq = 2 * t + 2;
+	return true;
+}
+
+// Next solution sent by another island, return false if there is none
+inline bool scp_island::receive( double & z, scp_solution & x )
+{
+	uint64_t head;
+
+	if ( !_header ) return false;
+
+	head = __sync_fetch_and_add( &_header->head, 0 );
+
+	if ( head > capacity && _next < head - capacity )
+	{
+		_next = head - capacity;
+	}
+
+	while ( _next < head )
+	{
+		slot * s = _slot( _next );
+		uint64_t seq = s->seq;
+		int island, size;
+
+		// Not written yet: wait for the next call
+		if ( seq < 2 * _next + 2 ) return false;
+
+		__sync_synchronize();
+		island = s->island;
+		size = std::max( 0, std::min( int( s->size ), _header->slot_size ) );
+		z = s->z;
+		std::copy( reinterpret_cast<const int32_t *>( s + 1 ), reinterpret_cast<const int32_t *>( s + 1 ) + size, _buffer.begin() );
+		__sync_synchronize();
+
+		// Overwritten, or sent by this island?
+		if ( s->seq != 2 * _next + 2 || island == _id )
+		{
+			++_next;
+			continue;
+		}
+
+		++_next;
+
+		// The columns of a slot written twice at once may be anything
+		x.clear();
+		for ( int k = 0; k < size; ++k )
+		{
+			if ( _buffer[k] >= 0 && _buffer[k] < _header->m )
+			{
+				x.insert( _buffer[k] );
+			}
+		}
+		return true;
+	}
+	return false;
+}
+
+// Send the best solution of the driver if it improved since the last
+// call, and offer it those of the other islands, return the number of
+// solutions it adopted
+inline int scp_island::exchange( scp_driver & driver )
+{
+	double z = 0;
+	int adopted = 0;
+
+	if ( driver.z() < _z_sent && send( driver.z(), driver.x() ) )
+	{
+		_z_sent = driver.z();
+	}
+
+	while ( receive( z, _migrant ) )
+	{
+		if ( driver.migrate( z, _migrant ) )
+		{
+			++adopted;
+
+			if ( driver.log )
+			{
+				*driver.log << "[" << driver.iterations() << "] Migrant: " << z << std::endl;
+			}
+		}
+	}
+	return adopted;
+}
+
+// Costs and index of the segment
+inline void scp_island::_read()
+{
+	const double * c = reinterpret_cast<const double *>( static_cast<char *>( _data ) + _header->costs );
+
+	_instance.clear();
+	_instance.c.assign( c, c + _header->m );
+	_index.attach( static_cast<char *>( _data ) + _header->index );
+
+	_buffer.assign( _header->slot_size, 0 );
+	_next = 0;
+
+	_z_sent = std::numeric_limits<double>::infinity();
+	_migrant.resize( _header->m );
+}
+
+inline scp_island::slot * scp_island::_slot( uint64_t t ) const
+{
+	return reinterpret_cast<slot *>( static_cast<char *>( _data ) + _header->ring + ( t % capacity ) * _header->stride );
+}
+
+inline std::size_t scp_island::_padded( std::size_t size )
+{
+	return ( size + 7 ) / 8 * 8;
+}
+
+// Size of a file, -1 if unknown
+inline int64_t scp_island::_file_size( const std::string & filename )
+{
+	struct stat st;
+
+	return stat( filename.c_str(), &st ) == 0 ? int64_t( st.st_size ) : -1;
+}
+
+#endif
@@ -17,14 +17,43 @@
 #define SCP_LOCAL_SEARCH_HPP
 
 #include <vector>
-#include <set>
 #include <algorithm>
 #include "scp_problem.hpp"
+#include "scp_solution.hpp"
+#include "scp_index.hpp"
+#include "scp_costs.hpp"
+#include "scp_stop.hpp"
+#include "scp_profile.hpp"
 
 /*
 	Class: scp_local_search
 
-	Set Cover Problem solver using GRASP metaheuristic.
+	Local search improving a feasible cover (an <scp_solution>, given by
+	read() or x()) until it is locally optimal, by three exchanges, each
+	run until no move of its kind improves the cost:
+
+	- 1-0: remove a column whose rows are all covered by others,
+	- 1-1: replace a column by a cheaper one covering its uncovered rows,
+	- 2-1: replace two columns by a cheaper one covering their uncovered
+	  rows.
+
+	run() selects the exchanges, and keeps the cover feasible.
+
+	The working arrays are allocated by read() and kept between runs: the
+	coverage of the rows is cleared along the columns of the solution at
+	the end of each run, and the 2-1 exchange updates it in place instead
+	of copying it for each pair of columns. The solution is sorted at the
+	end of a run, and can be swapped in from another solver with x().
+
+	On unicost instances, no 1-1 exchange is profitable, so it is skipped.
+	A column entering the solution by an exchange must cover every row left
+	uncovered, so the candidates are only the columns of the shortest of
+	these rows, visited in order: 3 columns on the Steiner triple instances
+	instead of all of them.
+
+	On integral instances, the costs are kept as int (see <scp_costs>), on
+	which the profitability of the exchanges is tested exactly, and which
+	are cheaper to scan.
 */
 struct scp_local_search
 {
@@ -38,100 +67,155 @@ struct scp_local_search
 	scp_local_search();
 
 	void read( const scp_problem & instance );
+	void read( const scp_problem & instance, const scp_index & index );
 	void read( const std::vector<double> & c );
-	void read( const std::set<int> & x );
+	void read( const scp_solution & x );
 	bool run( int exchanges = (_1_0 | _1_1 | _2_1) );
 
 	double z() const;
-	std::set<int> x() const;
+	bool feasible() const;
+	const scp_solution & x() const;
+	scp_solution & x();
+
+	std::size_t memory() const;
+
+	// Optional stopping criteria, polled between moves
+	const scp_stop * stop;
 
 private:
-	std::vector<double> _c;
-	std::vector< std::set<int> > _S, _T;
-	std::set<int> _x;
+	scp_costs _c;
+	scp_index _own_index;
+	const scp_index * _index;
+	scp_solution _x;
 	double _z;
+	int _uncovered;
+	bool _unicost;
 
-	void run_1_0( std::vector<int> & v );
-	void run_1_1( std::vector<int> & v );
-	void run_2_1( std::vector<int> & v );
+	// Workspaces: coverage of each row (null between runs), rows to cover
+	// by an exchange and all the columns
+	std::vector< int, scp_allocator<int> > _v;
+	std::vector<int> _to_cover, _all;
+
+	template <class R, class C> bool _run( int exchanges );
+	template <class R, class C> void run_1_0();
+	template <class R, class C> void run_1_1();
+	template <class R, class C> void run_2_1();
+
+	void _candidates( const int * & first, const int * & last ) const;
+
+	template <class R> void _cover( int i, int delta );
+
+	bool _expired() const;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
 
 inline scp_local_search::scp_local_search() :
-	_z( 0 )
+	stop( 0 ), _index( 0 ), _z( 0 ), _uncovered( 0 ), _unicost( false )
 {
 }
 
 inline void scp_local_search::read( const scp_problem & instance )
 {
-	int m = instance.num_elements(),
-	    n = instance.num_sets();
+	_own_index.build( instance );
+	read( instance, _own_index );
+}
 
-	std::set<int>::const_iterator it;
+// Share an index of the instance, which must outlive the solver
+inline void scp_local_search::read( const scp_problem & instance, const scp_index & index )
+{
+	int m = index.num_elements(),
+	    n = index.num_sets();
 
-	_c.clear();
-	_S.clear();
-	_T.clear();
+	read( instance.c );
+	_index = &index;
 
-	_c = instance.c;
-	_S = instance.S;
-	_T.resize( m, std::set<int>() );
+	_x.resize( m );
+	_v.assign( n, 0 );
+	_to_cover.clear();
+	_to_cover.reserve( n );
 
-	for ( int j = 0; j < n; ++j )
+	_all.resize( m );
+	for ( int i = 0; i < m; ++i )
 	{
-		for ( it = instance.S[j].begin(); it != instance.S[j].end(); ++it )
-		{
-			_T[*it].insert( j );
-		}
+		_all[i] = i;
 	}
 }
 
 inline void scp_local_search::read( const std::vector<double> & c )
 {
-	_c = c;
+	_c.assign( c );
+	_unicost = scp_unicost( c );
 }
 
-inline void scp_local_search::read( const std::set<int> & x )
+// Feasible solution, see also x() to swap it in
+inline void scp_local_search::read( const scp_solution & x )
 {
 	_x = x;
 }
 
 inline bool scp_local_search::run( int exchanges )
 {
-	int n = _S.size();
+	bool integral = _c.integral();
+
+	// Width of the row indices and type of the costs
+	if ( _index->compact() )
+	{
+		return integral ? _run<uint16_t, int>( exchanges ) : _run<uint16_t, double>( exchanges );
+	}
+	return integral ? _run<int, int>( exchanges ) : _run<int, double>( exchanges );
+}
+
+template <class R, class C>
+inline bool scp_local_search::_run( int exchanges )
+{
+	const C * c = _c.data<C>();
+	scp_solution::const_iterator it;
 
-	std::vector<int> v( n, 0 );
-	std::set<int>::const_iterator it, jt;
+	SCP_PROFILE_COUNT( local_search_runs );
 
 	_z = 0;
+	_uncovered = _index->num_sets();
 
 	for ( it = _x.begin(); it != _x.end(); ++it )
 	{
-		_z += _c[*it];
+		_z += c[*it];
+		_cover<R>( *it, 1 );
+	}
+
+	if ( exchanges & _1_0 ) run_1_0<R, C>();
+	if ( exchanges & _1_1 && !_unicost && !_expired() ) run_1_1<R, C>();
+	if ( exchanges & _2_1 && !_expired() ) run_2_1<R, C>();
+
+	_x.sort();
 
-		for ( jt = _T[*it].begin(); jt != _T[*it].end(); ++jt )
+	for ( it = _x.begin(); it != _x.end(); ++it )
+	{
+		for ( const R * jt = _index->T_begin<R>( *it ); jt != _index->T_end<R>( *it ); ++jt )
 		{
-			++v[*jt];
+			_v[*jt] = 0;
 		}
 	}
-
-	if ( exchanges & _1_0 ) run_1_0( v );
-	if ( exchanges & _1_1 ) run_1_1( v );
-	if ( exchanges & _2_1 ) run_2_1( v );
 	return true;
 }
 
-inline void scp_local_search::run_1_0( std::vector<int> & v )
+template <class R, class C>
+inline void scp_local_search::run_1_0()
 {
-	std::set<int>::iterator it, jt;
+	const C * c = _c.data<C>();
+	std::vector< int, scp_allocator<int> > & v = _v;
+	const R * jt;
 
-	// 1-0 exchange
-	for ( it = _x.begin(); it != _x.end(); )
+	SCP_PROFILE_TIMER( local_search_1_0 );
+
+	// 1-0 exchange: a removal moves the last column to the position p,
+	// which is visited again
+	for ( int p = 0; p < _x.size(); )
 	{
+		int i = _x[p];
 		bool is_useless = true;
 
-		for ( jt = _T[*it].begin(); is_useless && jt != _T[*it].end(); ++jt )
+		for ( jt = _index->T_begin<R>( i ); is_useless && jt != _index->T_end<R>( i ); ++jt )
 		{
 			if ( v[*jt] <= 1 )
 			{
@@ -141,64 +225,77 @@ inline void scp_local_search::run_1_0( std::vector<int> & v )
 
 		if ( is_useless )
 		{
-			for ( jt = _T[*it].begin(); is_useless && jt != _T[*it].end(); ++jt )
-			{
-				--v[*jt];
-			}
+			_cover<R>( i, -1 );
+			_z -= c[i];
+			_x.erase( i );
 
-			_z -= _c[*it];
-			_x.erase( it++ );
+			SCP_PROFILE_COUNT( local_search_1_0_moves );
 		}
 		else
 		{
-			++it;
+			++p;
 		}
 	}
 }
 
-inline void scp_local_search::run_1_1( std::vector<int> & v )
+template <class R, class C>
+inline void scp_local_search::run_1_1()
 {
-	int m = _T.size();
-
-	std::set<int>::iterator it, jt;
+	const C * c = _c.data<C>();
+	std::vector< int, scp_allocator<int> > & v = _v;
+	const R * jt;
 	bool improved = true;
 
-	// 2-1 exchange
-	while ( improved )
+	SCP_PROFILE_TIMER( local_search_1_1 );
+
+	// 1-1 exchange
+	while ( improved && !_expired() )
 	{
+		SCP_PROFILE_COUNT( local_search_1_1_restarts );
+
 		improved = false;
-		for ( it = _x.begin(); !improved && it != _x.end(); ++it )
+		for ( int p = 0; !improved && p < _x.size(); ++p )
 		{
-			std::set<int> to_cover;
+			int k = _x[p];
+
+			_to_cover.clear();
 
-			for ( jt = _T[*it].begin(); jt != _T[*it].end(); ++jt )
+			for ( jt = _index->T_begin<R>( k ); jt != _index->T_end<R>( k ); ++jt )
 			{
 				if ( v[*jt] <= 1 )
 				{
-					to_cover.insert( *jt );
+					_to_cover.push_back( *jt );
 				}
 			}
 
-			for ( int i = 0; !improved && i < m; ++i )
+			const int * it, * it_end;
+
+			_candidates( it, it_end );
+
+			for ( ; !improved && it != it_end; ++it )
 			{
-				if ( _c[i] - _c[*it] < 0            // Profitable exchange?
-				     && _x.find( i ) == _x.end()    // Is the item not already selected?
-				     && std::includes( _T[i].begin(), _T[i].end(), to_cover.begin(), to_cover.end() ) ) // Covers the subsets that need coverage?
+				int i = *it;
+
+				if ( c[i] - c[k] >= 0        // Unprofitable exchange?
+				     || _x.contains( i ) )  // Is the item already selected?
 				{
-					for ( jt = _T[*it].begin(); jt != _T[*it].end(); ++jt )
-					{
-						--v[*jt];
-					}
+					continue;
+				}
 
-					for ( jt = _T[i].begin(); jt != _T[i].end(); ++jt )
-					{
-						++v[*jt];
-					}
+				SCP_PROFILE_COUNT( local_search_1_1_includes );
 
-					_z += _c[i] - _c[*it];
-					_x.erase( it );
+				// Covers the subsets that need coverage?
+				if ( std::includes( _index->T_begin<R>( i ), _index->T_end<R>( i ), _to_cover.begin(), _to_cover.end() ) )
+				{
+					_cover<R>( k, -1 );
+					_cover<R>( i, 1 );
+
+					_z += c[i] - c[k];
+					_x.erase( k );
 					_x.insert( i );
 
+					SCP_PROFILE_COUNT( local_search_1_1_moves );
+
 					improved = true;
 				}
 			}
@@ -206,65 +303,99 @@ inline void scp_local_search::run_1_1( std::vector<int> & v )
 	}
 }
 
-inline void scp_local_search::run_2_1( std::vector<int> & v )
+template <class R, class C>
+inline void scp_local_search::run_2_1()
 {
-	int m = _T.size(),
-	    n = _S.size();
-
-	std::set<int>::iterator it, jt, kt;
+	const C * c = _c.data<C>();
+	std::vector< int, scp_allocator<int> > & v = _v;
 	bool improved = true;
 
+	SCP_PROFILE_TIMER( local_search_2_1 );
+
 	// 2-1 exchange
 	while ( improved )
 	{
+		SCP_PROFILE_COUNT( local_search_2_1_restarts );
+
 		improved = false;
-		for ( it = _x.begin(); !improved && it != _x.end(); ++it )
+		for ( int p = 0; !improved && p < _x.size() && !_expired(); ++p )
 		{
-			jt = it;
-			for ( ++jt; !improved && jt != _x.end(); ++jt )
+			for ( int q = p + 1; !improved && q < _x.size(); ++q )
 			{
-				std::vector<int> v_ij = v;
-				std::set<int> to_cover;
+				int k = _x[p], l = _x[q];
+				const R * kt = _index->T_begin<R>( k ), * kt_end = _index->T_end<R>( k ),
+				        * lt = _index->T_begin<R>( l ), * lt_end = _index->T_end<R>( l );
 
-				for ( kt = _T[*it].begin(); kt != _T[*it].end(); ++kt )
-				{
-					--v_ij[*kt];
-				}
+				SCP_PROFILE_COUNT( local_search_2_1_pairs );
 
-				for ( kt = _T[*jt].begin(); kt != _T[*jt].end(); ++kt )
-				{
-					--v_ij[*kt];
-				}
+				_cover<R>( k, -1 );
+				_cover<R>( l, -1 );
 
-				for ( int j = 0; j < n; ++j )
+				// Only the rows of k and l can become uncovered: merge
+				// them in order
+				_to_cover.clear();
+
+				while ( kt != kt_end || lt != lt_end )
 				{
-					if ( v_ij[j] <= 0 )
+					int j;
+
+					if ( lt == lt_end || ( kt != kt_end && *kt < *lt ) )
+					{
+						j = *kt++;
+					}
+					else if ( kt == kt_end || *lt < *kt )
+					{
+						j = *lt++;
+					}
+					else
+					{
+						j = *kt++;
+						++lt;
+					}
+
+					if ( v[j] <= 0 )
 					{
-						to_cover.insert( j );
+						_to_cover.push_back( j );
 					}
 				}
 
-				for ( int i = 0; !improved && i < m; ++i )
+				const int * it, * it_end;
+
+				_candidates( it, it_end );
+
+				for ( ; !improved && it != it_end; ++it )
 				{
-					if ( _c[i] - _c[*it] - _c[*jt] < 0    // Profitable exchange?
-					     && _x.find( i ) == _x.end()      // Is the item not already selected?
-					     && std::includes( _T[i].begin(), _T[i].end(), to_cover.begin(), to_cover.end() ) ) // Covers the subsets that need coverage?
+					int i = *it;
+
+					if ( c[i] - c[k] - c[l] >= 0      // Unprofitable exchange?
+					     || _x.contains( i ) )       // Is the item already selected?
 					{
-						// v_ij is the new v vector
-						for ( kt = _T[i].begin(); kt != _T[i].end(); ++kt )
-						{
-							++v_ij[*kt];
-						}
-
-						_z += _c[i] - _c[*it] - _c[*jt];
-						_x.erase( it );
-						_x.erase( jt );
+						continue;
+					}
+
+					SCP_PROFILE_COUNT( local_search_2_1_includes );
+
+					// Covers the subsets that need coverage?
+					if ( std::includes( _index->T_begin<R>( i ), _index->T_end<R>( i ), _to_cover.begin(), _to_cover.end() ) )
+					{
+						_cover<R>( i, 1 );
+
+						_z += c[i] - c[k] - c[l];
+						_x.erase( k );
+						_x.erase( l );
 						_x.insert( i );
 
-						v = v_ij;
+						SCP_PROFILE_COUNT( local_search_2_1_moves );
+
 						improved = true;
 					}
 				}
+
+				if ( !improved )
+				{
+					_cover<R>( k, 1 );
+					_cover<R>( l, 1 );
+				}
 			}
 		}
 	}
@@ -275,9 +406,76 @@ inline double scp_local_search::z() const
 	return _z;
 }
 
-inline std::set<int> scp_local_search::x() const
+// Whether the solution of the last run covers all the rows, the number of
+// uncovered rows being kept up to date by the moves
+inline bool scp_local_search::feasible() const
+{
+	return _uncovered == 0;
+}
+
+inline const scp_solution & scp_local_search::x() const
 {
 	return _x;
 }
 
+inline scp_solution & scp_local_search::x()
+{
+	return _x;
+}
+
+// Approximate number of bytes used, without a shared index
+inline std::size_t scp_local_search::memory() const
+{
+	return sizeof( *this ) - sizeof( _own_index ) + _own_index.memory()
+	     - sizeof( _c ) + _c.memory()
+	     - sizeof( _x ) + _x.memory()
+	     + ( _v.capacity() + _to_cover.capacity() + _all.capacity() ) * sizeof( int );
+}
+
+// Columns that may cover the rows to cover, in order: those of the
+// shortest row, or all of them if there is no row to cover
+inline void scp_local_search::_candidates( const int * & first, const int * & last ) const
+{
+	std::vector<int>::const_iterator jt;
+	int j_min = -1;
+
+	for ( jt = _to_cover.begin(); jt != _to_cover.end(); ++jt )
+	{
+		if ( j_min < 0 || _index->S_size( *jt ) < _index->S_size( j_min ) )
+		{
+			j_min = *jt;
+		}
+	}
+
+	if ( j_min < 0 )
+	{
+		first = _all.empty() ? 0 : &_all[0];
+		last = first + _all.size();
+	}
+	else
+	{
+		first = _index->S_begin( j_min );
+		last = _index->S_end( j_min );
+	}
+}
+
+// Add (delta = 1) or remove (delta = -1) the coverage of the column i
+template <class R>
+inline void scp_local_search::_cover( int i, int delta )
+{
+	for ( const R * jt = _index->T_begin<R>( i ); jt != _index->T_end<R>( i ); ++jt )
+	{
+		int & v = _v[*jt];
+
+		if ( v == 0 ) --_uncovered;
+		v += delta;
+		if ( v == 0 ) ++_uncovered;
+	}
+}
+
+inline bool scp_local_search::_expired() const
+{
+	return stop && stop->expired();
+}
+
 #endif
@@ -0,0 +1,422 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCP_LP_HPP
+#define SCP_LP_HPP
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include "scp_problem.hpp"
+#include "scp_index.hpp"
+
+/*
+	Class: scp_lp
+
+	Lower bound and dual values of the linear relaxation of the Set Cover
+	Problem, without LP solver, by subgradient optimization of its
+	Lagrangian relaxation, as in J.E. Beasley, "A lagrangian heuristic for
+	set-covering problems" (1990).
+
+	For multipliers u >= 0 of the rows, the columns of negative reduced cost
+	c_i - sum of u_j over the rows of the column give the Lagrangian bound
+
+		L(u) = sum of u_j + sum of the negative reduced costs,
+
+	which is a lower bound of the integer and linear optima for any u, and
+	whose maximum is the linear optimum, the multipliers being then its
+	dual values. Each iteration moves u along the rows left uncovered or
+	covered several times by these columns, and completes them into a
+	solution which gives an upper bound. It costs two passes over the
+	index, far less than solving the linear program.
+
+	The step is halved when the bound does not improve for a while, and
+	the optimization stops when the step vanishes or the bounds meet.
+
+	Multipliers computed elsewhere, such as the dual values of CPLEX (see
+	<scp_solver_cplex>), can also be read to get their bound and reduced
+	costs, and to fix the columns by reduced cost (see <fix>).
+*/
+struct scp_lp
+{
+	scp_lp();
+
+	void read( const scp_problem & instance );
+	void read( const scp_problem & instance, const scp_index & index );
+	void read( const std::vector<double> & u );
+	bool run();
+
+	double z() const;
+	double z_upper() const;
+	int iterations() const;
+
+	const std::vector<double> & duals() const;
+	const std::vector<double> & reduced_costs() const;
+
+	int fix( double z_upper, std::vector<bool> & fixed ) const;
+
+	std::size_t memory() const;
+
+	// Maximum number of iterations, and number of iterations without
+	// improvement of the bound before the step is halved
+	int max_iterations,
+	    period;
+
+	// Initial and final step factors
+	double step,
+	       min_step;
+
+	double epsilon;
+
+private:
+	const scp_problem * _instance;
+	scp_index _own_index;
+	const scp_index * _index;
+	bool _integral;
+	int _iterations;
+
+	// Best bound and its multipliers and reduced costs, best upper bound
+	double _z, _z_upper;
+	std::vector<double> _duals, _reduced_costs;
+
+	// Workspaces: current multipliers, reduced costs and subgradient,
+	// solution of the heuristic, coverage of each row, and columns by
+	// decreasing cost
+	std::vector<double> _u, _r, _s;
+	std::vector<bool> _x;
+	std::vector<int> _v, _order;
+
+	template <class R> bool _run();
+	template <class R> double _evaluate( const std::vector<double> & u );
+	template <class R> double _upper();
+	template <class R> void _cover( int i, int k );
+};
+
+// Sorts the columns by decreasing cost
+struct scp_cost_greater
+{
+	scp_cost_greater( const std::vector<double> & cost ) : c( cost ) {}
+
+	bool operator () ( int a, int b ) const
+	{
+		return c[a] > c[b] || ( c[a] == c[b] && a < b );
+	}
+
+	const std::vector<double> & c;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline scp_lp::scp_lp() :
+	max_iterations( 1000 ), period( 30 ), step( 2 ), min_step( 0.005 ), epsilon( 1e-9 ),
+	_instance( 0 ), _index( 0 ), _integral( false ), _iterations( 0 ), _z( 0 ), _z_upper( 0 )
+{
+}
+
+inline void scp_lp::read( const scp_problem & instance )
+{
+	_own_index.build( instance );
+	read( instance, _own_index );
+}
+
+// Share an index of the instance, which must outlive the solver
+inline void scp_lp::read( const scp_problem & instance, const scp_index & index )
+{
+	int m = index.num_elements(),
+	    n = index.num_sets();
+
+	_instance = &instance;
+	_index = &index;
+	_integral = instance.integral();
+
+	_u.assign( n, 0 );
+	_s.assign( n, 0 );
+	_v.assign( n, 0 );
+	_r.assign( m, 0 );
+	_x.assign( m, false );
+
+	_order.resize( m );
+	for ( int i = 0; i < m; ++i ) _order[i] = i;
+	std::sort( _order.begin(), _order.end(), scp_cost_greater( instance.c ) );
+
+	_duals.assign( n, 0 );
+	_reduced_costs = instance.c;
+	_z = 0;
+	_z_upper = std::numeric_limits<double>::infinity();
+	_iterations = 0;
+}
+
+// Multipliers of the rows, such as dual values, completed into a solution
+// as by run() for the upper bound
+inline void scp_lp::read( const std::vector<double> & u )
+{
+	_z = _index->compact() ? _evaluate<uint16_t>( u ) : _evaluate<int>( u );
+	_duals = u;
+	_reduced_costs = _r;
+	_z_upper = std::min( _z_upper, _index->compact() ? _upper<uint16_t>() : _upper<int>() );
+}
+
+// Return false if the instance is infeasible
+inline bool scp_lp::run()
+{
+	return _index->compact() ? _run<uint16_t>() : _run<int>();
+}
+
+// Best lower bound
+inline double scp_lp::z() const
+{
+	return _z;
+}
+
+// Best objective value of the solutions completed along the way, or from
+// the multipliers read
+inline double scp_lp::z_upper() const
+{
+	return _z_upper;
+}
+
+inline int scp_lp::iterations() const
+{
+	return _iterations;
+}
+
+// Multipliers of the best bound, approximate dual values of the rows
+inline const std::vector<double> & scp_lp::duals() const
+{
+	return _duals;
+}
+
+inline const std::vector<double> & scp_lp::reduced_costs() const
+{
+	return _reduced_costs;
+}
+
+// Mark the columns which are in no solution better than z_upper: taking
+// a column of positive reduced cost raises the bound by as much. Return
+// the number of columns fixed
+inline int scp_lp::fix( double z_upper, std::vector<bool> & fixed ) const
+{
+	int m = _reduced_costs.size(), count = 0;
+
+	fixed.assign( m, false );
+
+	for ( int i = 0; i < m; ++i )
+	{
+		if ( _reduced_costs[i] > 0 && _z + _reduced_costs[i] > z_upper + epsilon )
+		{
+			fixed[i] = true;
+			++count;
+		}
+	}
+	return count;
+}
+
+inline std::size_t scp_lp::memory() const
+{
+	return sizeof( *this )
+	     + _own_index.memory()
+	     + ( _duals.capacity() + _reduced_costs.capacity() + _u.capacity() + _r.capacity() + _s.capacity() ) * sizeof( double )
+	     + _x.capacity() / 8
+	     + ( _v.capacity() + _order.capacity() ) * sizeof( int );
+}
+
+template <class R>
+inline bool scp_lp::_run()
+{
+	int n = _index->num_sets(),
+	    stall = 0;
+	double lambda = step;
+
+	_iterations = 0;
+
+	// Initial multipliers: the smallest cost per row of the columns of
+	// each row
+	for ( int j = 0; j < n; ++j )
+	{
+		const int * it, * end = _index->S_end( j );
+
+		if ( _index->S_begin( j ) == end ) return false;
+
+		_u[j] = std::numeric_limits<double>::infinity();
+		for ( it = _index->S_begin( j ); it != end; ++it )
+		{
+			_u[j] = std::min( _u[j], _instance->c[*it] / _index->T_size( *it ) );
+		}
+	}
+
+	_z = -std::numeric_limits<double>::infinity();
+	_z_upper = std::numeric_limits<double>::infinity();
+
+	while ( _iterations < max_iterations && lambda >= min_step )
+	{
+		double z = _evaluate<R>( _u ), norm = 0;
+
+		++_iterations;
+
+		if ( z > _z + epsilon )
+		{
+			_z = z;
+			_duals = _u;
+			_reduced_costs = _r;
+			stall = 0;
+		}
+		else if ( ++stall >= period )
+		{
+			lambda /= 2;
+			stall = 0;
+		}
+
+		_z_upper = std::min( _z_upper, _upper<R>() );
+
+		// Optimal when the bounds meet, up to rounding on integral costs
+		if ( _z_upper - ( _integral ? std::ceil( _z - epsilon ) : _z ) <= epsilon )
+		{
+			break;
+		}
+
+		// Subgradient: 1 - number of columns of the rows, not lowering
+		// the null multipliers
+		for ( int j = 0; j < n; ++j )
+		{
+			const int * it, * end = _index->S_end( j );
+
+			_s[j] = 1;
+			for ( it = _index->S_begin( j ); it != end; ++it )
+			{
+				if ( _r[*it] < 0 ) _s[j] -= 1;
+			}
+			if ( _u[j] <= 0 && _s[j] < 0 ) _s[j] = 0;
+
+			norm += _s[j] * _s[j];
+		}
+
+		if ( norm == 0 )
+		{
+			break;
+		}
+
+		// Step towards a target slightly above the upper bound
+		for ( int j = 0; j < n; ++j )
+		{
+			_u[j] = std::max( 0., _u[j] + lambda * ( 1.05 * _z_upper - z ) / norm * _s[j] );
+		}
+	}
+
+	return true;
+}
+
+// Reduced costs and Lagrangian bound of the multipliers
+template <class R>
+inline double scp_lp::_evaluate( const std::vector<double> & u )
+{
+	int m = _index->num_elements(),
+	    n = _index->num_sets();
+	double z = 0;
+
+	for ( int j = 0; j < n; ++j )
+	{
+		z += u[j];
+	}
+
+	for ( int i = 0; i < m; ++i )
+	{
+		const R * jt, * end = _index->T_end<R>( i );
+
+		_r[i] = _instance->c[i];
+		for ( jt = _index->T_begin<R>( i ); jt != end; ++jt )
+		{
+			_r[i] -= u[*jt];
+		}
+		if ( _r[i] < 0 ) z += _r[i];
+	}
+	return z;
+}
+
+// Objective value of the columns of negative reduced cost, completed by
+// the cheapest column of each row left uncovered, and without the
+// redundant columns, the most expensive first (infinity if a row has no
+// column)
+template <class R>
+inline double scp_lp::_upper()
+{
+	int m = _index->num_elements(),
+	    n = _index->num_sets();
+	double z = 0;
+
+	std::fill( _v.begin(), _v.end(), 0 );
+
+	for ( int i = 0; i < m; ++i )
+	{
+		_x[i] = false;
+		if ( _r[i] < 0 ) _cover<R>( i, 1 );
+	}
+
+	for ( int j = 0; j < n; ++j )
+	{
+		const int * it, * end = _index->S_end( j );
+		int best = -1;
+
+		if ( _v[j] > 0 ) continue;
+
+		for ( it = _index->S_begin( j ); it != end; ++it )
+		{
+			if ( best < 0 || _instance->c[*it] < _instance->c[best] ) best = *it;
+		}
+
+		// A row of no column, such as one whose columns are all fixed,
+		// has no cover
+		if ( best < 0 ) return std::numeric_limits<double>::infinity();
+
+		_cover<R>( best, 1 );
+	}
+
+	for ( int p = 0; p < m; ++p )
+	{
+		int i = _order[p];
+		const R * jt, * end = _index->T_end<R>( i );
+		bool redundant = _x[i];
+
+		for ( jt = _index->T_begin<R>( i ); redundant && jt != end; ++jt )
+		{
+			redundant = _v[*jt] > 1;
+		}
+
+		if ( redundant )
+		{
+			_cover<R>( i, -1 );
+		}
+		else if ( _x[i] )
+		{
+			z += _instance->c[i];
+		}
+	}
+	return z;
+}
+
+// Add (k = 1) or remove (k = -1) a column of the solution of the heuristic
+template <class R>
+inline void scp_lp::_cover( int i, int k )
+{
+	const R * jt, * end = _index->T_end<R>( i );
+
+	_x[i] = ( k > 0 );
+	for ( jt = _index->T_begin<R>( i ); jt != end; ++jt )
+	{
+		_v[*jt] += k;
+	}
+}
+
+#endif
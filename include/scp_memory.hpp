@@ -0,0 +1,317 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCP_MEMORY_HPP
+#define SCP_MEMORY_HPP
+
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <new>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstddef>
+#include <stdint.h>
+
+/*
+	Class: scp_memory
+
+	Allocation of the large arrays of the solvers (index, costs, coverage
+	counts), which are read at random positions: with the usual 4 KB pages,
+	the arrays of a large instance span far more pages than the TLB holds,
+	and most accesses miss it. They can be backed by huge pages instead:
+
+	- normal:      usual pages,
+	- thp:         transparent huge pages, requested by madvise (they are
+	               used only if the kernel has free huge pages at hand),
+	- explicit:    pages of the huge page pool (MAP_HUGETLB), reserved by
+	               the administrator in /proc/sys/vm/nr_hugepages, or
+	               transparent ones when the pool is empty.
+
+	Only the blocks of at least a huge page are concerned: they are mapped
+	aligned on a huge page, and their size rounded up to a whole number of
+	huge pages, whatever the mode, so that a block is released the same way
+	whichever mode it was allocated with. Smaller blocks use operator new.
+
+	The mode is global, and should be selected before loading the instance.
+*/
+struct scp_memory
+{
+	enum pages_type
+	{
+		normal,
+		thp,
+		explicit_pages
+	};
+
+	static pages_type pages();
+	static void pages( pages_type p );
+	static bool pages( const std::string & name );
+	static const char * name( pages_type p );
+
+	static std::size_t huge_page_size();
+
+	static void * allocate( std::size_t size );
+	static void deallocate( void * p, std::size_t size );
+
+	static std::size_t mapped( pages_type p );
+	static std::size_t backed();
+
+	static void write( std::ostream & os );
+
+private:
+	// Blocks mapped, by address, with their length and pages
+	struct registry
+	{
+		registry() { pthread_mutex_init( &mutex, 0 ); }
+
+		pthread_mutex_t mutex;
+		std::map< void *, std::pair<std::size_t, pages_type> > blocks;
+	};
+
+	static pages_type & _pages();
+	static registry & _registry();
+	static void * _record( void * p, std::size_t length, pages_type pages );
+	static std::size_t _read_kb( const std::string & filename, const std::string & key );
+};
+
+/*
+	Class: scp_allocator
+
+	Standard allocator of the containers of large arrays, by <scp_memory>.
+*/
+template <class T>
+struct scp_allocator
+{
+	typedef T value_type;
+	typedef T * pointer;
+	typedef const T * const_pointer;
+	typedef T & reference;
+	typedef const T & const_reference;
+	typedef std::size_t size_type;
+	typedef std::ptrdiff_t difference_type;
+
+	template <class U> struct rebind { typedef scp_allocator<U> other; };
+
+	scp_allocator() {}
+	template <class U> scp_allocator( const scp_allocator<U> & ) {}
+
+	pointer address( reference x ) const { return &x; }
+	const_pointer address( const_reference x ) const { return &x; }
+
+	pointer allocate( size_type n, const void * = 0 )
+	{
+		return static_cast<pointer>( scp_memory::allocate( n * sizeof( T ) ) );
+	}
+	void deallocate( pointer p, size_type n )
+	{
+		scp_memory::deallocate( p, n * sizeof( T ) );
+	}
+
+	size_type max_size() const { return size_type( -1 ) / sizeof( T ); }
+
+	void construct( pointer p, const T & x ) { new ( p ) T( x ); }
+	void destroy( pointer p ) { p->~T(); }
+};
+
+template <class T, class U>
+inline bool operator == ( const scp_allocator<T> &, const scp_allocator<U> & ) { return true; }
+
+template <class T, class U>
+inline bool operator != ( const scp_allocator<T> &, const scp_allocator<U> & ) { return false; }
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline scp_memory::pages_type scp_memory::pages()
+{
+	return _pages();
+}
+
+inline void scp_memory::pages( pages_type p )
+{
+	_pages() = p;
+}
+
+inline bool scp_memory::pages( const std::string & name )
+{
+	for ( int p = normal; p <= explicit_pages; ++p )
+	{
+		if ( name == scp_memory::name( pages_type( p ) ) )
+		{
+			pages( pages_type( p ) );
+			return true;
+		}
+	}
+	return false;
+}
+
+inline const char * scp_memory::name( pages_type p )
+{
+	switch ( p )
+	{
+		case thp:            return "thp";
+		case explicit_pages: return "explicit";
+		case normal:
+		default:             return "normal";
+	}
+}
+
+// Default size of the huge pages, 2 MB if unknown
+inline std::size_t scp_memory::huge_page_size()
+{
+	static const std::size_t size = _read_kb( "/proc/meminfo", "Hugepagesize:" ) * 1024;
+
+	return size > 0 ? size : 2 << 20;
+}
+
+inline void * scp_memory::allocate( std::size_t size )
+{
+	std::size_t huge = huge_page_size(),
+	            length = ( size + huge - 1 ) / huge * huge;
+	char * p, * q;
+
+	if ( size < huge )
+	{
+		return ::operator new( size );
+	}
+
+#ifdef MAP_HUGETLB
+	if ( pages() == explicit_pages )
+	{
+		p = static_cast<char *>( mmap( 0, length, PROT_READ | PROT_WRITE,
+		                               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 ) );
+		if ( p != MAP_FAILED )
+		{
+			return _record( p, length, explicit_pages );
+		}
+	}
+#endif
+
+	// Aligned on a huge page: map one more, and unmap the ends
+	q = static_cast<char *>( mmap( 0, length + huge, PROT_READ | PROT_WRITE,
+	                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 ) );
+	if ( q == MAP_FAILED )
+	{
+		throw std::bad_alloc();
+	}
+
+	p = reinterpret_cast<char *>( ( uintptr_t( q ) + huge - 1 ) / huge * huge );
+	if ( p > q ) munmap( q, p - q );
+	if ( p < q + huge ) munmap( p + length, q + huge - p );
+
+#ifdef MADV_HUGEPAGE
+	if ( pages() != normal && madvise( p, length, MADV_HUGEPAGE ) == 0 )
+	{
+		return _record( p, length, thp );
+	}
+#endif
+
+	return _record( p, length, normal );
+}
+
+inline void scp_memory::deallocate( void * p, std::size_t size )
+{
+	std::size_t huge = huge_page_size(),
+	            length = ( size + huge - 1 ) / huge * huge;
+
+	if ( size < huge )
+	{
+		::operator delete( p );
+		return;
+	}
+
+	pthread_mutex_lock( &_registry().mutex );
+	_registry().blocks.erase( p );
+	pthread_mutex_unlock( &_registry().mutex );
+
+	munmap( p, length );
+}
+
+// Number of bytes of the large blocks currently mapped with the given pages
+inline std::size_t scp_memory::mapped( pages_type p )
+{
+	std::map< void *, std::pair<std::size_t, pages_type> >::const_iterator it;
+	std::size_t total = 0;
+
+	pthread_mutex_lock( &_registry().mutex );
+	for ( it = _registry().blocks.begin(); it != _registry().blocks.end(); ++it )
+	{
+		if ( it->second.second == p ) total += it->second.first;
+	}
+	pthread_mutex_unlock( &_registry().mutex );
+
+	return total;
+}
+
+// Number of bytes of the process actually backed by transparent huge pages
+inline std::size_t scp_memory::backed()
+{
+	return _read_kb( "/proc/self/smaps_rollup", "AnonHugePages:" ) * 1024;
+}
+
+inline void scp_memory::write( std::ostream & os )
+{
+	os << "Pages: " << name( pages() )
+	   << " | huge = " << huge_page_size() / 1024 << " KB"
+	   << " | explicit = " << mapped( explicit_pages ) / 1048576. << " MB"
+	   << " | thp = " << mapped( thp ) / 1048576. << " MB"
+	   << " (backed = " << backed() / 1048576. << " MB)"
+	   << " | normal = " << mapped( normal ) / 1048576. << " MB" << std::endl;
+}
+
+inline scp_memory::pages_type & scp_memory::_pages()
+{
+	static pages_type p = normal;
+	return p;
+}
+
+// Never destroyed, since static containers may still release blocks at exit
+inline scp_memory::registry & scp_memory::_registry()
+{
+	static registry * r = new registry;
+	return *r;
+}
+
+inline void * scp_memory::_record( void * p, std::size_t length, pages_type pages )
+{
+	pthread_mutex_lock( &_registry().mutex );
+	_registry().blocks[p] = std::make_pair( length, pages );
+	pthread_mutex_unlock( &_registry().mutex );
+
+	return p;
+}
+
+inline std::size_t scp_memory::_read_kb( const std::string & filename, const std::string & key )
+{
+	std::ifstream file( filename.c_str() );
+	std::string line;
+
+	while ( std::getline( file, line ) )
+	{
+		if ( line.compare( 0, key.size(), key ) == 0 )
+		{
+			std::istringstream iss( line.substr( key.size() ) );
+			std::size_t kb = 0;
+
+			iss >> kb;
+			return kb;
+		}
+	}
+	return 0;
+}
+
+#endif
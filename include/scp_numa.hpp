@@ -0,0 +1,226 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCP_NUMA_HPP
+#define SCP_NUMA_HPP
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/*
+	Class: scp_numa
+
+	NUMA topology of the machine, read from /sys/devices/system/node and
+	restricted to the processors the process may run on, without library.
+	Without NUMA support, the machine is a single node.
+
+	Memory is placed by the kernel on the node of the thread which first
+	touches it, so that a thread pinned to a node (see <pin>) allocates
+	and fills its data node-locally. <pages> reports where the pages of an
+	array actually are.
+*/
+struct scp_numa
+{
+	scp_numa();
+
+	int num_nodes() const;
+	int node( int k ) const;
+	const std::vector<int> & cpus( int k ) const;
+
+	int worker_node( int worker ) const;
+	int worker_cpu( int worker ) const;
+
+	static bool pin( int cpu );
+	static bool pin( const std::vector<int> & cpus );
+
+	static void pages( const void * data, std::size_t size, std::vector<int> & count,
+	                   int max_pages = 4096 );
+
+private:
+	std::vector<int> _nodes;
+	std::vector< std::vector<int> > _cpus;
+
+	static bool _read_list( const std::string & filename, std::vector<int> & list );
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline scp_numa::scp_numa()
+{
+	std::vector<int> nodes;
+	cpu_set_t allowed;
+
+	CPU_ZERO( &allowed );
+	sched_getaffinity( 0, sizeof( allowed ), &allowed );
+
+	_read_list( "/sys/devices/system/node/online", nodes );
+
+	for ( std::size_t k = 0; k < nodes.size(); ++k )
+	{
+		std::ostringstream filename;
+		std::vector<int> list, cpus;
+
+		filename << "/sys/devices/system/node/node" << nodes[k] << "/cpulist";
+		_read_list( filename.str(), list );
+
+		for ( std::size_t i = 0; i < list.size(); ++i )
+		{
+			if ( list[i] < CPU_SETSIZE && CPU_ISSET( list[i], &allowed ) )
+			{
+				cpus.push_back( list[i] );
+			}
+		}
+
+		// Nodes without processors (memory only) cannot run workers
+		if ( !cpus.empty() )
+		{
+			_nodes.push_back( nodes[k] );
+			_cpus.push_back( cpus );
+		}
+	}
+
+	if ( _nodes.empty() )
+	{
+		std::vector<int> cpus;
+
+		for ( int i = 0; i < CPU_SETSIZE; ++i )
+		{
+			if ( CPU_ISSET( i, &allowed ) ) cpus.push_back( i );
+		}
+		if ( cpus.empty() ) cpus.push_back( 0 );
+
+		_nodes.push_back( 0 );
+		_cpus.push_back( cpus );
+	}
+}
+
+inline int scp_numa::num_nodes() const
+{
+	return _nodes.size();
+}
+
+// Number of the k-th node, as known by the kernel
+inline int scp_numa::node( int k ) const
+{
+	return _nodes[k];
+}
+
+// Processors of the k-th node
+inline const std::vector<int> & scp_numa::cpus( int k ) const
+{
+	return _cpus[k];
+}
+
+// Workers are spread over the nodes in turn, then over their processors
+inline int scp_numa::worker_node( int worker ) const
+{
+	return worker % num_nodes();
+}
+
+inline int scp_numa::worker_cpu( int worker ) const
+{
+	const std::vector<int> & c = _cpus[worker_node( worker )];
+	return c[worker / num_nodes() % c.size()];
+}
+
+// Pin the calling thread to a processor, or to a set of processors
+inline bool scp_numa::pin( int cpu )
+{
+	return pin( std::vector<int>( 1, cpu ) );
+}
+
+inline bool scp_numa::pin( const std::vector<int> & cpus )
+{
+	cpu_set_t set;
+
+	CPU_ZERO( &set );
+	for ( std::size_t i = 0; i < cpus.size(); ++i )
+	{
+		CPU_SET( cpus[i], &set );
+	}
+	return pthread_setaffinity_np( pthread_self(), sizeof( set ), &set ) == 0;
+}
+
+// Count the pages of an array on each node (indexed by node number),
+// sampling at most max_pages pages. The pages not allocated yet, or whose
+// node is unknown, are not counted
+inline void scp_numa::pages( const void * data, std::size_t size, std::vector<int> & count, int max_pages )
+{
+	long page_size = sysconf( _SC_PAGESIZE );
+	uintptr_t first = uintptr_t( data ) / page_size * page_size,
+	          last = uintptr_t( data ) + size;
+	long num_pages = ( last - first + page_size - 1 ) / page_size,
+	     step = num_pages / max_pages + 1;
+	std::vector<void *> addresses;
+	std::vector<int> status;
+
+	if ( !data || size == 0 ) return;
+
+	for ( long p = 0; p < num_pages; p += step )
+	{
+		addresses.push_back( reinterpret_cast<void *>( first + p * page_size ) );
+	}
+	status.assign( addresses.size(), -1 );
+
+#ifdef SYS_move_pages
+	// Without target nodes, move_pages only queries the nodes
+	if ( syscall( SYS_move_pages, 0, addresses.size(), &addresses[0], (const int *) 0, &status[0], 0 ) != 0 )
+	{
+		return;
+	}
+#endif
+
+	for ( std::size_t p = 0; p < status.size(); ++p )
+	{
+		if ( status[p] >= 0 )
+		{
+			if ( int( count.size() ) <= status[p] ) count.resize( status[p] + 1, 0 );
+			++count[status[p]];
+		}
+	}
+}
+
+// Read a list of ranges such as "0-3,8,10-11"
+inline bool scp_numa::_read_list( const std::string & filename, std::vector<int> & list )
+{
+	std::ifstream file( filename.c_str() );
+	std::string token;
+
+	list.clear();
+
+	while ( std::getline( file, token, ',' ) )
+	{
+		int a = 0, b = 0;
+
+		switch ( std::sscanf( token.c_str(), "%d-%d", &a, &b ) )
+		{
+			case 1: b = a; // Fall through
+			case 2:
+				for ( int i = a; i <= b; ++i ) list.push_back( i );
+				break;
+		}
+	}
+	return !list.empty();
+}
+
+#endif
@@ -0,0 +1,94 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCP_PARALLEL_HPP
+#define SCP_PARALLEL_HPP
+
+#include <pthread.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "scp_driver.hpp"
+#include "scp_index.hpp"
+#include "scp_island.hpp"
+#include "scp_scheduler.hpp"
+#include "scp_numa.hpp"
+
+/*
+	Class: scp_parallel
+
+	Parallel run of the tries of a driver by several threads, each one with
+	its own copy of the driver, the tries being distributed by a
+	<scp_scheduler>.
+
+	The try k draws its random numbers from the seed and k only, so that,
+	without Reactive GRASP, the solutions found do not depend on the
+	number of threads nor on the scheduling. Each try is recorded in the
+	original driver (see <scp_driver::merge>), which thus holds the
+	statistics, evaluates the stopping criteria, writes the streams and
+	exchanges solutions with the other islands, if any.
+
+	Each thread builds its copy of the driver itself, so that its working
+	arrays are allocated on its node. With <numa>, the threads are pinned
+	to processors spread over the NUMA nodes, and the index is replicated
+	on each node where it is not already, so that the solvers only read
+	local memory.
+*/
+struct scp_parallel
+{
+	scp_parallel();
+	~scp_parallel();
+
+	void run( scp_driver & driver, int num_threads, unsigned int seed,
+	          scp_island * island = 0, int migration = 0 );
+
+	int steals() const;
+	void write_numa( std::ostream & os ) const;
+
+	// Pin the threads and replicate the index per NUMA node
+	bool numa;
+
+private:
+	struct task
+	{
+		scp_parallel * self;
+		int worker;
+	};
+
+	scp_driver * _driver;
+	std::vector<scp_driver *> _workers;
+	scp_scheduler _scheduler;
+
+	// Topology, and index used on each node (null for that of the driver)
+	scp_numa _topology;
+	std::vector<scp_index *> _replicas;
+	unsigned int _seed;
+	scp_island * _island;
+	int _migration;
+	std::string _error;
+
+	pthread_mutex_t _mutex;
+
+	static void * _worker( void * t );
+	void _work( int worker );
+	void _replicate( int num_threads );
+	void _clear();
+
+	static void _pages( const scp_index & index, std::vector<int> & count );
+
+	static uint64_t _mix( uint64_t s );
+};
+
+#endif
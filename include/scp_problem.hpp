@@ -18,12 +18,17 @@
 
 #include <iostream>
 #include <vector>
-#include <set>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <stdint.h>
+#include "scp_solution.hpp"
 
 /*
 	Class: scp_problem
 
-	Set Cover Problem instance.
+	Set Cover Problem instance. The elements of each set are stored in a
+	sorted vector without duplicates (see <normalize>).
 */
 struct scp_problem
 {
@@ -31,25 +36,54 @@ struct scp_problem
 	int num_sets() const;
 
 	void clear();
+	void normalize();
 	void reduce();
 
-	double z( const std::set<int> & x ) const;
+	bool unicost() const;
+	bool integral() const;
+
+	std::size_t memory() const;
+
+	double z( const scp_solution & x ) const;
 
 	bool check() const;
-	bool check( const std::set<int> & x ) const;
-	bool check( const std::set<int> & x, double obj, double epsilon = 1e-9 ) const;
+	bool check( const scp_solution & x ) const;
+	bool check( const scp_solution & x, double obj, double epsilon = 1e-9 ) const;
 
-	void read( std::istream & is );
-	void read_rail( std::istream & is );
-	void read_stn( std::istream & is );
+	bool read( std::istream & is );
+	bool read_rail( std::istream & is );
+	bool read_stn( std::istream & is );
+	bool read_binary( std::istream & is );
 	void write( std::ostream & os ) const;
+	void write_binary( std::ostream & os ) const;
 
 	std::vector<double> c;
-	std::vector< std::set<int> > S;
+	std::vector< std::vector<int> > S;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
 
+/*
+	Number of bytes left in a seekable stream, such as a file or a request
+	read in memory, or the largest size if it cannot be told (pipe, gzip
+	file). The readers bound the counts of the header by it before sizing
+	the instance, so that a truncated or forged header cannot allocate more
+	memory than its data.
+*/
+inline std::size_t scp_remaining( std::istream & is )
+{
+	std::streampos here, end;
+
+	if ( is.eof() ) return 0;
+	if ( ( here = is.tellg() ) < 0 ) return std::size_t( -1 );
+
+	is.seekg( 0, std::ios::end );
+	end = is.tellg();
+	is.seekg( here );
+
+	return end < here ? std::size_t( -1 ) : std::size_t( end - here );
+}
+
 inline int scp_problem::num_elements() const
 {
 	return c.size();
@@ -66,51 +100,113 @@ inline void scp_problem::clear()
 	S.clear();
 }
 
+// Sort the elements of each set, remove the duplicates and release the
+// unused capacity
+inline void scp_problem::normalize()
+{
+	int n = num_sets();
+
+	for ( int j = 0; j < n; ++j )
+	{
+		std::sort( S[j].begin(), S[j].end() );
+		S[j].erase( std::unique( S[j].begin(), S[j].end() ), S[j].end() );
+
+		if ( S[j].capacity() > S[j].size() )
+		{
+			std::vector<int>( S[j] ).swap( S[j] );
+		}
+	}
+}
+
+// Remove the elements that are in no set, and renumber the others
 inline void scp_problem::reduce()
 {
-	int m = num_elements(), n = num_sets();
-	std::set<int>::iterator it;
+	int m = num_elements(), n = num_sets(), k = 0;
+	std::vector<int> index( m, -1 );
+
+	for ( int j = 0; j < n; ++j )
+	{
+		for ( std::size_t p = 0; p < S[j].size(); ++p )
+		{
+			index[S[j][p]] = 0;
+		}
+	}
 
 	for ( int i = 0; i < m; ++i )
 	{
-		bool found = false;
+		if ( index[i] == 0 )
+		{
+			c[k] = c[i];
+			index[i] = k++;
+		}
+	}
+
+	c.resize( k );
 
-		for ( int j = 0; !found && j < n; ++j )
+	for ( int j = 0; j < n; ++j )
+	{
+		for ( std::size_t p = 0; p < S[j].size(); ++p )
 		{
-			if ( S[j].find( i ) != S[j].end() )
-			{
-				found = true;
-			}
+			S[j][p] = index[S[j][p]];
 		}
+	}
+}
 
-		if ( !found )
+// Whether all the costs are equal
+inline bool scp_unicost( const std::vector<double> & c )
+{
+	for ( std::size_t i = 1; i < c.size(); ++i )
+	{
+		if ( c[i] != c[0] )
 		{
-			for ( int j = 0; !found && j < n; ++j )
-			{
-				it = S[j].lower_bound( i );
-
-				if ( it != S[j].end() )
-				{
-					if ( *it == i )
-						S[j].erase( it++ );
-					else
-						++it;
-
-					while ( it != S[j].end() )
-					{
-						int k = *it;
-						S[j].erase( it++ );
-						S[j].insert( k-1 );
-					}
-				}
-			}
+			return false;
+		}
+	}
+	return true;
+}
+
+inline bool scp_problem::unicost() const
+{
+	return scp_unicost( c );
+}
+
+// Whether all the costs are integers below 2^29 in absolute value, so that
+// they fit in an int with the sums and differences of up to three of them
+inline bool scp_integral( const std::vector<double> & c )
+{
+	for ( std::size_t i = 0; i < c.size(); ++i )
+	{
+		// Range and NaN first, the conversion of the others being undefined
+		if ( c[i] >= 536870912. || c[i] <= -536870912. || c[i] != c[i] || c[i] != std::floor( c[i] ) )
+		{
+			return false;
 		}
 	}
+	return true;
 }
 
-inline double scp_problem::z( const std::set<int> & x ) const
+inline bool scp_problem::integral() const
 {
-	std::set<int>::const_iterator it;
+	return scp_integral( c );
+}
+
+// Approximate number of bytes used
+inline std::size_t scp_problem::memory() const
+{
+	std::size_t bytes = sizeof( *this )
+	                  + c.capacity() * sizeof( double )
+	                  + S.capacity() * sizeof( std::vector<int> );
+
+	for ( std::size_t j = 0; j < S.size(); ++j )
+	{
+		bytes += S[j].capacity() * sizeof( int );
+	}
+	return bytes;
+}
+
+inline double scp_problem::z( const scp_solution & x ) const
+{
+	scp_solution::const_iterator it;
 	double obj = 0;
 
 	for ( it = x.begin(); it != x.end(); ++it )
@@ -134,10 +230,10 @@ inline bool scp_problem::check() const
 	return true;
 }
 
-inline bool scp_problem::check( const std::set<int> & x ) const
+inline bool scp_problem::check( const scp_solution & x ) const
 {
 	int n = num_sets();
-	std::set<int>::const_iterator it;
+	std::vector<int>::const_iterator it;
 
 	for ( int j = 0; j < n; ++j )
 	{
@@ -145,7 +241,7 @@ inline bool scp_problem::check( const std::set<int> & x ) const
 
 		for ( it = S[j].begin(); !covered && it != S[j].end(); ++it )
 		{
-			if ( x.find( *it ) != x.end() )
+			if ( x.contains( *it ) )
 			{
 				covered = true;
 			}
@@ -159,19 +255,26 @@ inline bool scp_problem::check( const std::set<int> & x ) const
 	return true;
 }
 
-inline bool scp_problem::check( const std::set<int> & x, double obj, double epsilon ) const
+inline bool scp_problem::check( const scp_solution & x, double obj, double epsilon ) const
 {
 	double diff = z( x ) - obj;
 	return -epsilon <= diff && diff <= epsilon && check( x );
 }
 
-inline void scp_problem::read( std::istream & is )
+inline bool scp_problem::read( std::istream & is )
 {
 	int m, n, p, l;
 
 	is >> n >> m;
 
 	clear();
+
+	// Each cost and row size takes a digit and a separator
+	if ( !is || m < 0 || n < 0 || std::size_t( m ) + n > scp_remaining( is ) / 2 + 1 )
+	{
+		is.setstate( std::ios::failbit );
+		return false;
+	}
 	c.resize( m );
 	S.resize( n );
 
@@ -180,25 +283,43 @@ inline void scp_problem::read( std::istream & is )
 		is >> c[i];
 	}
 
-	for ( int j = 0; j < n; ++j )
+	for ( int j = 0; is && j < n; ++j )
 	{
 		is >> p;
 
-		for ( int k = 0; k < p; ++k )
+		if ( 0 < p && p <= m )
+		{
+			S[j].reserve( p );
+		}
+
+		for ( int k = 0; is && k < p; ++k )
 		{
 			is >> l;
-			S[j].insert( l-1 );
+
+			if ( l < 1 || l > m ) is.setstate( std::ios::failbit );
+			S[j].push_back( l-1 );
 		}
 	}
+
+	normalize();
+	return !is.fail();
 }
 
-inline void scp_problem::read_rail( std::istream & is )
+inline bool scp_problem::read_rail( std::istream & is )
 {
 	int m, n, p, l;
 
 	is >> n >> m;
 
 	clear();
+
+	// Each column takes a cost and a size, and each row is named by a
+	// column at least, a row of no column making the instance infeasible
+	if ( !is || m < 0 || n < 0 || 2 * std::size_t( m ) + n > scp_remaining( is ) / 2 + 1 )
+	{
+		is.setstate( std::ios::failbit );
+		return false;
+	}
 	c.resize( m );
 	S.resize( n );
 
@@ -206,32 +327,121 @@ inline void scp_problem::read_rail( std::istream & is )
 	{
 		is >> c[i] >> p;
 
-		for ( int k = 0; k < p; ++k )
+		for ( int k = 0; is && k < p; ++k )
 		{
 			is >> l;
-			S[l-1].insert( i );
+
+			if ( !is || l < 1 || l > n )
+			{
+				is.setstate( std::ios::failbit );
+				break;
+			}
+			S[l-1].push_back( i );
 		}
 	}
+
+	normalize();
+	return !is.fail();
 }
 
-inline void scp_problem::read_stn( std::istream & is )
+inline bool scp_problem::read_stn( std::istream & is )
 {
 	int m, n, l;
 
 	is >> m >> n;
 
 	clear();
+
+	// Each row names its three columns, and each column is in a row
+	if ( !is || m < 0 || n < 0 || std::max( std::size_t( m ), 3 * std::size_t( n ) ) > scp_remaining( is ) / 2 + 1 )
+	{
+		is.setstate( std::ios::failbit );
+		return false;
+	}
 	c.resize( m, 1 );
 	S.resize( n );
 
 	for ( int j = 0; j < n; ++j )
 	{
-		for ( int k = 0; k < 3; ++k )
+		for ( int k = 0; is && k < 3; ++k )
 		{
 			is >> l;
-			S[j].insert( l-1 );
+
+			if ( l < 1 || l > m ) is.setstate( std::ios::failbit );
+			S[j].push_back( l-1 );
 		}
 	}
+
+	normalize();
+	return !is.fail();
+}
+
+/*
+	Binary format, in native byte order: the magic "SCPB", the number of
+	rows n and of columns m (int32), the m costs (double), then for each
+	row its number of columns (int32) followed by the columns (int32,
+	starting from 0). Sets the failbit of the stream on a bad magic, size
+	or column, or on sizes larger than the data left in the stream.
+*/
+inline bool scp_problem::read_binary( std::istream & is )
+{
+	char magic[4];
+	int32_t m, n, p, l;
+
+	clear();
+
+	if ( !is.read( magic, 4 ) || std::memcmp( magic, "SCPB", 4 ) != 0 )
+	{
+		is.setstate( std::ios::failbit );
+		return false;
+	}
+
+	is.read( reinterpret_cast<char *>( &n ), sizeof( n ) );
+	is.read( reinterpret_cast<char *>( &m ), sizeof( m ) );
+
+	// Each cost takes 8 bytes and each row size 4, and the columns of a
+	// row are not sized before its size is bounded by m
+	if ( !is || m < 0 || n < 0 || 8 * std::size_t( m ) + 4 * std::size_t( n ) > scp_remaining( is ) )
+	{
+		is.setstate( std::ios::failbit );
+		return false;
+	}
+
+	c.resize( m );
+	S.resize( n );
+
+	if ( m > 0 )
+	{
+		is.read( reinterpret_cast<char *>( &c[0] ), m * sizeof( double ) );
+	}
+
+	for ( int j = 0; is && j < n; ++j )
+	{
+		is.read( reinterpret_cast<char *>( &p ), sizeof( p ) );
+
+		if ( !is || p < 0 || p > m )
+		{
+			is.setstate( std::ios::failbit );
+			return false;
+		}
+
+		S[j].resize( p );
+
+		for ( int k = 0; k < p; ++k )
+		{
+			is.read( reinterpret_cast<char *>( &l ), sizeof( l ) );
+
+			if ( !is || l < 0 || l >= m )
+			{
+				is.setstate( std::ios::failbit );
+				return false;
+			}
+			S[j][k] = l;
+		}
+	}
+
+	normalize();
+	return !is.fail();
 }
 
 inline void scp_problem::write( std::ostream & os ) const
@@ -239,25 +449,53 @@ inline void scp_problem::write( std::ostream & os ) const
 	int m = num_elements(),
 	    n = num_sets();
 
-	os << n << ' ' << m << std::endl;
+	os << n << ' ' << m << '\n';
 
 	for ( int i = 0; i < m; ++i )
 	{
 		if ( i > 0 ) os << ' ';
 		os << c[i];
 	}
-	os << std::endl;
+	os << '\n';
 
 	for ( int j = 0; j < n; ++j )
 	{
-		std::set<int>::const_iterator it;
+		std::vector<int>::const_iterator it;
 
-		os << S[j].size() << std::endl;
+		os << S[j].size() << '\n';
 		for ( it = S[j].begin(); it != S[j].end(); ++it )
 		{
 			os << ' ' << *it+1;
 		}
-		os << std::endl;
+		os << '\n';
+	}
+}
+
+inline void scp_problem::write_binary( std::ostream & os ) const
+{
+	int32_t m = num_elements(),
+	        n = num_sets();
+
+	os.write( "SCPB", 4 );
+	os.write( reinterpret_cast<const char *>( &n ), sizeof( n ) );
+	os.write( reinterpret_cast<const char *>( &m ), sizeof( m ) );
+
+	if ( m > 0 )
+	{
+		os.write( reinterpret_cast<const char *>( &c[0] ), m * sizeof( double ) );
+	}
+
+	for ( int j = 0; j < n; ++j )
+	{
+		std::vector<int>::const_iterator it;
+		int32_t p = S[j].size();
+
+		os.write( reinterpret_cast<const char *>( &p ), sizeof( p ) );
+		for ( it = S[j].begin(); it != S[j].end(); ++it )
+		{
+			int32_t l = *it;
+			os.write( reinterpret_cast<const char *>( &l ), sizeof( l ) );
+		}
 	}
 }
 
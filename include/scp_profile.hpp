@@ -0,0 +1,244 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCP_PROFILE_HPP
+#define SCP_PROFILE_HPP
+
+#include <stdint.h>
+#include <pthread.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include "chrono.hpp"
+
+/*
+	Class: scp_profile
+
+	Hot-path instrumentation: event counters and scoped timers, kept per
+	thread and summed by <write>.
+
+	The instrumentation is compiled only with -DSCP_PROFILE (e.g. make
+	DFLAGS=-DSCP_PROFILE), otherwise the macros expand to nothing.
+*/
+struct scp_profile
+{
+	enum counter
+	{
+		grasp_runs,
+		grasp_steps,
+		grasp_scanned,
+		grasp_candidates,
+		local_search_runs,
+		local_search_1_0_moves,
+		local_search_1_1_restarts,
+		local_search_1_1_includes,
+		local_search_1_1_moves,
+		local_search_2_1_restarts,
+		local_search_2_1_pairs,
+		local_search_2_1_includes,
+		local_search_2_1_moves,
+		repair_runs,
+		repair_steps,
+		repair_candidates,
+		num_counters
+	};
+
+	enum timer
+	{
+		grasp_run,
+		local_search_1_0,
+		local_search_1_1,
+		local_search_2_1,
+		repair_run,
+		num_timers
+	};
+
+	struct data
+	{
+		uint64_t counters[num_counters],
+		         calls[num_timers];
+		double seconds[num_timers];
+	};
+
+	static data & local();
+	static void write( std::ostream & os );
+
+	static const char * name( counter c );
+	static const char * name( timer t );
+
+private:
+	static std::vector<data *> & _threads();
+	static pthread_mutex_t & _mutex();
+};
+
+/*
+	Class: scp_profile_timer
+
+	Adds the time spent in a scope to a timer of <scp_profile>.
+*/
+struct scp_profile_timer
+{
+	scp_profile_timer( scp_profile::timer t );
+	~scp_profile_timer();
+
+private:
+	scp_profile::timer _t;
+	chrono::time_point _begin;
+};
+
+#ifdef SCP_PROFILE
+#define SCP_PROFILE_ADD( c, n ) ( scp_profile::local().counters[scp_profile::c] += ( n ) )
+#define SCP_PROFILE_COUNT( c ) SCP_PROFILE_ADD( c, 1 )
+#define SCP_PROFILE_TIMER( t ) scp_profile_timer _scp_profile_timer( scp_profile::t )
+#else
+#define SCP_PROFILE_ADD( c, n ) ( (void) 0 )
+#define SCP_PROFILE_COUNT( c ) ( (void) 0 )
+#define SCP_PROFILE_TIMER( t ) ( (void) 0 )
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Counters of the calling thread, registered at first use
+inline scp_profile::data & scp_profile::local()
+{
+	static __thread data * d = 0;
+
+	if ( !d )
+	{
+		d = new data();
+
+		pthread_mutex_lock( &_mutex() );
+		_threads().push_back( d );
+		pthread_mutex_unlock( &_mutex() );
+	}
+	return *d;
+}
+
+inline void scp_profile::write( std::ostream & os )
+{
+	data total = data();
+	std::size_t num_threads;
+
+	pthread_mutex_lock( &_mutex() );
+
+	num_threads = _threads().size();
+
+	for ( std::size_t k = 0; k < num_threads; ++k )
+	{
+		const data & d = *_threads()[k];
+
+		for ( int c = 0; c < num_counters; ++c )
+		{
+			total.counters[c] += d.counters[c];
+		}
+
+		for ( int t = 0; t < num_timers; ++t )
+		{
+			total.seconds[t] += d.seconds[t];
+			total.calls[t] += d.calls[t];
+		}
+	}
+
+	pthread_mutex_unlock( &_mutex() );
+
+	os << "Profile (" << num_threads << " threads):" << std::endl;
+
+	for ( int c = 0; c < num_counters; ++c )
+	{
+		os << "  " << std::left << std::setw( 28 ) << name( counter( c ) )
+		   << std::right << std::setw( 16 ) << total.counters[c] << std::endl;
+	}
+
+	for ( int t = 0; t < num_timers; ++t )
+	{
+		double s = total.seconds[t];
+
+		os << "  " << std::left << std::setw( 28 ) << name( timer( t ) )
+		   << std::right << std::setw( 16 ) << total.calls[t] << " calls"
+		   << std::setw( 14 ) << s << " s";
+
+		if ( total.calls[t] > 0 )
+		{
+			os << std::setw( 14 ) << 1e6 * s / double( total.calls[t] ) << " us/call";
+		}
+		os << std::endl;
+	}
+}
+
+inline const char * scp_profile::name( counter c )
+{
+	static const char * names[num_counters] =
+	{
+		"grasp.runs",
+		"grasp.steps",
+		"grasp.scanned",
+		"grasp.candidates",
+		"local_search.runs",
+		"local_search.1_0.moves",
+		"local_search.1_1.restarts",
+		"local_search.1_1.includes",
+		"local_search.1_1.moves",
+		"local_search.2_1.restarts",
+		"local_search.2_1.pairs",
+		"local_search.2_1.includes",
+		"local_search.2_1.moves",
+		"repair.runs",
+		"repair.steps",
+		"repair.candidates"
+	};
+	return names[c];
+}
+
+inline const char * scp_profile::name( timer t )
+{
+	static const char * names[num_timers] =
+	{
+		"grasp.run",
+		"local_search.run_1_0",
+		"local_search.run_1_1",
+		"local_search.run_2_1",
+		"repair.run"
+	};
+	return names[t];
+}
+
+inline std::vector<scp_profile::data *> & scp_profile::_threads()
+{
+	static std::vector<data *> threads;
+	return threads;
+}
+
+inline pthread_mutex_t & scp_profile::_mutex()
+{
+	static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+	return mutex;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline scp_profile_timer::scp_profile_timer( scp_profile::timer t ) :
+	_t( t ), _begin( chrono::now( chrono::tsc ) )
+{
+}
+
+inline scp_profile_timer::~scp_profile_timer()
+{
+	scp_profile::data & d = scp_profile::local();
+
+	d.seconds[_t] += chrono::now( chrono::tsc ) - _begin;
+	++d.calls[_t];
+}
+
+#endif
@@ -0,0 +1,80 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCP_RANDOM_HPP
+#define SCP_RANDOM_HPP
+
+#include <stdint.h>
+
+/*
+	Class: scp_random
+
+	Random number generator (xorshift64*). Unlike std::rand(), each solver
+	owns its state, so that solvers can run in parallel threads.
+*/
+struct scp_random
+{
+	scp_random( uint64_t s = 1 );
+
+	void seed( uint64_t s );
+
+	uint32_t operator () ();
+	int operator () ( int n );
+	double uniform();
+
+private:
+	uint64_t _s;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline scp_random::scp_random( uint64_t s )
+{
+	seed( s );
+}
+
+inline void scp_random::seed( uint64_t s )
+{
+	_s = s ^ UINT64_C( 0x9E3779B97F4A7C15 );
+
+	// The state must not be zero
+	if ( _s == 0 )
+	{
+		_s = 1;
+	}
+}
+
+// 32 random bits
+inline uint32_t scp_random::operator () ()
+{
+	_s ^= _s >> 12;
+	_s ^= _s << 25;
+	_s ^= _s >> 27;
+	return uint32_t( ( _s * UINT64_C( 2685821657736338717 ) ) >> 32 );
+}
+
+// Uniform integer in [0,n)
+inline int scp_random::operator () ( int n )
+{
+	return int( ( uint64_t( (*this)() ) * uint64_t( n ) ) >> 32 );
+}
+
+// Uniform real in [0,1)
+inline double scp_random::uniform()
+{
+	return (*this)() / 4294967296.;
+}
+
+#endif
@@ -0,0 +1,265 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCP_REACTIVE_HPP
+#define SCP_REACTIVE_HPP
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <limits>
+#include <cmath>
+#include "scp_random.hpp"
+
+/*
+	Class: scp_reactive
+
+	Reactive GRASP: selection of the RCL threshold parameter among a
+	discrete set of values, with probabilities periodically updated from
+	the quality of the solutions found with each value [Prais & Ribeiro].
+*/
+struct scp_reactive
+{
+	scp_reactive( int b = 20, double d = 10 );
+
+	void read( const std::vector<double> & a );
+	void read( const std::string & s );
+	void reset();
+
+	int select();
+	void update( int k, double z );
+	void merge( const scp_reactive & reactive );
+
+	int size() const;
+	double alpha( int k ) const;
+	double probability( int k ) const;
+	int count( int k ) const;
+	double average( int k ) const;
+	double best( int k ) const;
+
+	void write( std::ostream & os ) const;
+	void write_table( std::ostream & os ) const;
+
+	int block;
+	double delta;
+
+	scp_random rng;
+
+private:
+	std::vector<double> _alpha, _p, _sum, _best;
+	std::vector<int> _count;
+	double _z_best;
+	int _iterations;
+
+	void _update_probabilities();
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline scp_reactive::scp_reactive( int b, double d ) :
+	block( b ), delta( d ),
+	_z_best( std::numeric_limits<double>::infinity() ), _iterations( 0 )
+{
+}
+
+inline void scp_reactive::read( const std::vector<double> & a )
+{
+	_alpha = a;
+	reset();
+}
+
+// Forget the statistics, keep the alpha values
+inline void scp_reactive::reset()
+{
+	int l = _alpha.size();
+
+	_p.assign( l, 1. / double( l ) );
+	_sum.assign( l, 0 );
+	_best.assign( l, std::numeric_limits<double>::infinity() );
+	_count.assign( l, 0 );
+	_z_best = std::numeric_limits<double>::infinity();
+	_iterations = 0;
+}
+
+// Read a comma-separated list of values, e.g. "0.1,0.5,0.9", ignoring the
+// values out of [0,1]
+inline void scp_reactive::read( const std::string & s )
+{
+	std::istringstream iss( s );
+	std::vector<double> a;
+	std::string token;
+	double value;
+
+	while ( std::getline( iss, token, ',' ) )
+	{
+		if ( std::istringstream( token ) >> value && value >= 0 && value <= 1 )
+		{
+			a.push_back( value );
+		}
+	}
+	read( a );
+}
+
+inline int scp_reactive::select()
+{
+	int l = _alpha.size();
+	double r = rng.uniform(), s = 0;
+
+	for ( int k = 0; k < l - 1; ++k )
+	{
+		s += _p[k];
+
+		if ( r < s )
+		{
+			return k;
+		}
+	}
+	return l - 1;
+}
+
+inline void scp_reactive::update( int k, double z )
+{
+	++_count[k];
+	_sum[k] += z;
+
+	if ( z < _best[k] ) _best[k] = z;
+	if ( z < _z_best ) _z_best = z;
+
+	if ( block > 0 && ++_iterations % block == 0 )
+	{
+		_update_probabilities();
+	}
+}
+
+// Add the statistics of another selection over the same values, such as
+// that of another thread, and update the probabilities
+inline void scp_reactive::merge( const scp_reactive & reactive )
+{
+	int l = _alpha.size();
+
+	for ( int k = 0; k < l && k < reactive.size(); ++k )
+	{
+		_count[k] += reactive._count[k];
+		_sum[k] += reactive._sum[k];
+
+		if ( reactive._best[k] < _best[k] ) _best[k] = reactive._best[k];
+	}
+
+	if ( reactive._z_best < _z_best ) _z_best = reactive._z_best;
+	_iterations += reactive._iterations;
+
+	_update_probabilities();
+}
+
+inline int scp_reactive::size() const
+{
+	return _alpha.size();
+}
+
+inline double scp_reactive::alpha( int k ) const
+{
+	return _alpha[k];
+}
+
+inline double scp_reactive::probability( int k ) const
+{
+	return _p[k];
+}
+
+inline int scp_reactive::count( int k ) const
+{
+	return _count[k];
+}
+
+inline double scp_reactive::average( int k ) const
+{
+	return _count[k] > 0 ? _sum[k] / double( _count[k] ) : 0;
+}
+
+inline double scp_reactive::best( int k ) const
+{
+	return _best[k];
+}
+
+inline void scp_reactive::write( std::ostream & os ) const
+{
+	int l = _alpha.size();
+
+	for ( int k = 0; k < l; ++k )
+	{
+		os << "alpha = " << _alpha[k]
+		   << " | p = " << _p[k]
+		   << " | count = " << _count[k];
+
+		if ( _count[k] > 0 )
+		{
+			os << " | avg = " << average( k )
+			   << " | best = " << _best[k];
+		}
+		os << std::endl;
+	}
+}
+
+// Same statistics as write(), as a table with a header line, for scripts.
+// The average and best values of an alpha never drawn are "-"
+inline void scp_reactive::write_table( std::ostream & os ) const
+{
+	int l = _alpha.size();
+
+	os << "alpha p count avg best" << std::endl;
+
+	for ( int k = 0; k < l; ++k )
+	{
+		os << _alpha[k] << ' ' << _p[k] << ' ' << _count[k] << ' ';
+
+		if ( _count[k] > 0 )
+		{
+			os << average( k ) << ' ' << _best[k];
+		}
+		else
+		{
+			os << "- -";
+		}
+		os << std::endl;
+	}
+}
+
+inline void scp_reactive::_update_probabilities()
+{
+	int l = _alpha.size();
+	std::vector<double> q( l, 1 );
+	double sum_q = 0;
+
+	for ( int k = 0; k < l; ++k )
+	{
+		double avg = average( k );
+
+		// Values not tried yet (or non-positive objectives) keep the
+		// highest score so that they still get a chance to be selected
+		if ( _count[k] > 0 && avg > 0 && _z_best > 0 )
+		{
+			q[k] = std::pow( _z_best / avg, delta );
+		}
+		sum_q += q[k];
+	}
+
+	for ( int k = 0; k < l; ++k )
+	{
+		_p[k] = q[k] / sum_q;
+	}
+}
+
+#endif
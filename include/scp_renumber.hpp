@@ -0,0 +1,393 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCP_RENUMBER_HPP
+#define SCP_RENUMBER_HPP
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "scp_problem.hpp"
+
+/*
+	Orders of the rows and columns of an instance.
+
+	- none: order of the file,
+	- cost: columns by increasing cost per row (the greedy efficiency),
+	        rows in the order in which these columns first cover them,
+	- rcm:  reverse Cuthill-McKee order of the bipartite graph of the rows
+	        and columns, which keeps the rows of each column and the
+	        columns of each row close to each other.
+*/
+enum scp_order
+{
+	order_none,
+	order_cost,
+	order_rcm
+};
+
+bool scp_order_parse( const std::string & s, scp_order & order );
+const char * scp_order_name( scp_order order );
+
+/*
+	Class: scp_renumbering
+
+	Permutation of the rows and columns of an instance, to improve the
+	locality of the solvers: adding a column reads the coverage of its rows,
+	then the uncovered counts of their columns, which are scattered over
+	the arrays in the order of the file.
+
+	The solvers run on the renumbered instance (see <apply>), whose columns
+	are mapped back to the original ones on output by <columns>.
+*/
+struct scp_renumbering
+{
+	void build( const scp_problem & instance, scp_order order );
+	void apply( scp_problem & instance ) const;
+
+	static void spread( const scp_problem & instance, double & rows, double & columns );
+
+	// Original number of each column and row, by new number
+	std::vector<int> columns, rows;
+
+private:
+	// Number of columns of each row and of rows of each column
+	std::vector<int> _row_degree, _column_degree;
+
+	void _build_cost( const scp_problem & instance, const std::vector< std::vector<int> > & T );
+	void _build_rcm( const scp_problem & instance, const std::vector< std::vector<int> > & T );
+	int _bfs( const scp_problem & instance, const std::vector< std::vector<int> > & T, int root,
+	          std::vector<int> & row_number, std::vector<int> & column_number,
+	          int & next_row, int & next_column );
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline bool scp_order_parse( const std::string & s, scp_order & order )
+{
+	if ( s == "none" || s.empty() )
+	{
+		order = order_none;
+	}
+	else if ( s == "cost" )
+	{
+		order = order_cost;
+	}
+	else if ( s == "rcm" )
+	{
+		order = order_rcm;
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
+inline const char * scp_order_name( scp_order order )
+{
+	switch ( order )
+	{
+		case order_cost: return "cost";
+		case order_rcm:  return "rcm";
+		case order_none:
+		default:         return "none";
+	}
+}
+
+// Sorts the rows and columns by degree, the neighbors being visited by
+// increasing degree
+struct scp_degree_less
+{
+	scp_degree_less( const std::vector<int> & d ) : degree( d ) {}
+
+	bool operator () ( int a, int b ) const
+	{
+		return degree[a] < degree[b] || ( degree[a] == degree[b] && a < b );
+	}
+
+	const std::vector<int> & degree;
+};
+
+// Sorts the columns by cost per row, the columns covering no row last
+struct scp_efficiency_less
+{
+	scp_efficiency_less( const std::vector<double> & cost, const std::vector< std::vector<int> > & t ) : c( cost ), T( t ) {}
+
+	bool operator () ( int a, int b ) const
+	{
+		if ( T[a].empty() || T[b].empty() )
+		{
+			return !T[a].empty() && T[b].empty();
+		}
+		return c[a] * T[b].size() < c[b] * T[a].size();
+	}
+
+	const std::vector<double> & c;
+	const std::vector< std::vector<int> > & T;
+};
+
+inline void scp_renumbering::build( const scp_problem & instance, scp_order order )
+{
+	int m = instance.num_elements(), n = instance.num_sets();
+	std::vector< std::vector<int> > T( m );
+
+	columns.resize( m );
+	rows.resize( n );
+
+	for ( int i = 0; i < m; ++i ) columns[i] = i;
+	for ( int j = 0; j < n; ++j ) rows[j] = j;
+
+	if ( order == order_none )
+	{
+		return;
+	}
+
+	for ( int j = 0; j < n; ++j )
+	{
+		for ( std::size_t p = 0; p < instance.S[j].size(); ++p )
+		{
+			T[instance.S[j][p]].push_back( j );
+		}
+	}
+
+	if ( order == order_cost )
+	{
+		_build_cost( instance, T );
+	}
+	else
+	{
+		_build_rcm( instance, T );
+	}
+}
+
+// Renumber the instance, which must be the one given to build()
+inline void scp_renumbering::apply( scp_problem & instance ) const
+{
+	int m = columns.size(), n = rows.size();
+	std::vector<int> number( m );
+	scp_problem renumbered;
+
+	for ( int i = 0; i < m; ++i )
+	{
+		number[columns[i]] = i;
+	}
+
+	renumbered.c.resize( m );
+	renumbered.S.resize( n );
+
+	for ( int i = 0; i < m; ++i )
+	{
+		renumbered.c[i] = instance.c[columns[i]];
+	}
+
+	for ( int j = 0; j < n; ++j )
+	{
+		const std::vector<int> & s = instance.S[rows[j]];
+
+		renumbered.S[j].resize( s.size() );
+		for ( std::size_t p = 0; p < s.size(); ++p )
+		{
+			renumbered.S[j][p] = number[s[p]];
+		}
+		std::sort( renumbered.S[j].begin(), renumbered.S[j].end() );
+	}
+
+	std::swap( instance.c, renumbered.c );
+	std::swap( instance.S, renumbered.S );
+}
+
+// Average distance between the first and last row of a column, and the
+// first and last column of a row, relative to the number of rows and
+// columns
+inline void scp_renumbering::spread( const scp_problem & instance, double & rows, double & columns )
+{
+	int m = instance.num_elements(), n = instance.num_sets();
+	std::vector<int> first( m, n ), last( m, -1 );
+	double sum = 0;
+	int count = 0;
+
+	for ( int j = 0; j < n; ++j )
+	{
+		const std::vector<int> & s = instance.S[j];
+
+		if ( s.empty() ) continue;
+
+		sum += *std::max_element( s.begin(), s.end() ) - *std::min_element( s.begin(), s.end() );
+		for ( std::size_t p = 0; p < s.size(); ++p )
+		{
+			first[s[p]] = std::min( first[s[p]], j );
+			last[s[p]] = std::max( last[s[p]], j );
+		}
+		++count;
+	}
+	columns = count > 0 && m > 0 ? sum / count / m : 0;
+
+	sum = 0;
+	count = 0;
+	for ( int i = 0; i < m; ++i )
+	{
+		if ( last[i] < 0 ) continue;
+
+		sum += last[i] - first[i];
+		++count;
+	}
+	rows = count > 0 && n > 0 ? sum / count / n : 0;
+}
+
+// Columns by efficiency, and rows by the first column covering them
+inline void scp_renumbering::_build_cost( const scp_problem & instance, const std::vector< std::vector<int> > & T )
+{
+	int m = instance.num_elements(), n = instance.num_sets(), next_row = 0;
+	std::vector<bool> numbered( n, false );
+
+	std::stable_sort( columns.begin(), columns.end(), scp_efficiency_less( instance.c, T ) );
+
+	for ( int k = 0; k < m; ++k )
+	{
+		const std::vector<int> & t = T[columns[k]];
+
+		for ( std::size_t p = 0; p < t.size(); ++p )
+		{
+			if ( !numbered[t[p]] )
+			{
+				numbered[t[p]] = true;
+				rows[next_row++] = t[p];
+			}
+		}
+	}
+
+	// Rows covered by no column
+	for ( int j = 0; j < n; ++j )
+	{
+		if ( !numbered[j] ) rows[next_row++] = j;
+	}
+}
+
+// Breadth-first search of each connected component from a row far from
+// the others (see _bfs), the numbers being reversed at the end
+inline void scp_renumbering::_build_rcm( const scp_problem & instance, const std::vector< std::vector<int> > & T )
+{
+	int m = instance.num_elements(), n = instance.num_sets(), next_row = 0, next_column = 0;
+	std::vector<int> row_number( n, -1 ), column_number( m, -1 ), order( n );
+
+	_row_degree.resize( n );
+	_column_degree.resize( m );
+
+	for ( int j = 0; j < n; ++j )
+	{
+		_row_degree[j] = instance.S[j].size();
+		order[j] = j;
+	}
+	for ( int i = 0; i < m; ++i )
+	{
+		_column_degree[i] = T[i].size();
+	}
+	std::sort( order.begin(), order.end(), scp_degree_less( _row_degree ) );
+
+	for ( int k = 0; k < n; ++k )
+	{
+		int root = order[k], first_row = next_row, first_column = next_column;
+
+		if ( row_number[root] >= 0 ) continue;
+
+		// A row of the last level of a first search is a better root,
+		// since the levels of a search from it are narrower
+		root = _bfs( instance, T, root, row_number, column_number, next_row, next_column );
+
+		for ( int p = first_row; p < next_row; ++p ) row_number[rows[p]] = -1;
+		for ( int p = first_column; p < next_column; ++p ) column_number[columns[p]] = -1;
+		next_row = first_row;
+		next_column = first_column;
+
+		_bfs( instance, T, root, row_number, column_number, next_row, next_column );
+	}
+
+	// Columns covering no row
+	for ( int i = 0; i < m; ++i )
+	{
+		if ( column_number[i] < 0 ) columns[next_column++] = i;
+	}
+
+	std::reverse( rows.begin(), rows.end() );
+	std::reverse( columns.begin(), columns.end() );
+
+	_row_degree.clear();
+	_column_degree.clear();
+}
+
+// Number the rows and columns reached from the root, each row before its
+// columns by increasing degree, and return a row of minimum degree of the
+// last level
+inline int scp_renumbering::_bfs( const scp_problem & instance, const std::vector< std::vector<int> > & T, int root,
+                                  std::vector<int> & row_number, std::vector<int> & column_number,
+                                  int & next_row, int & next_column )
+{
+	int head = next_row, level_start = next_row, level_end = next_row + 1, last = root;
+
+	row_number[root] = next_row;
+	rows[next_row++] = root;
+
+	while ( head < next_row )
+	{
+		int j = rows[head++], first_column = next_column;
+
+		for ( std::size_t p = 0; p < instance.S[j].size(); ++p )
+		{
+			int i = instance.S[j][p];
+
+			if ( column_number[i] < 0 )
+			{
+				column_number[i] = next_column;
+				columns[next_column++] = i;
+			}
+		}
+		std::sort( columns.begin() + first_column, columns.begin() + next_column, scp_degree_less( _column_degree ) );
+
+		for ( int q = first_column; q < next_column; ++q )
+		{
+			int i = columns[q], first_row = next_row;
+
+			column_number[i] = q;
+			for ( std::size_t p = 0; p < T[i].size(); ++p )
+			{
+				int k = T[i][p];
+
+				if ( row_number[k] < 0 )
+				{
+					row_number[k] = next_row;
+					rows[next_row++] = k;
+				}
+			}
+			std::sort( rows.begin() + first_row, rows.begin() + next_row, scp_degree_less( _row_degree ) );
+			for ( int p = first_row; p < next_row; ++p ) row_number[rows[p]] = p;
+		}
+
+		// Level completed: the next one is the rows found meanwhile
+		if ( head == level_end && head < next_row )
+		{
+			level_start = head;
+			level_end = next_row;
+		}
+	}
+
+	for ( int p = level_start; p < level_end; ++p )
+	{
+		if ( p == level_start || _row_degree[rows[p]] < _row_degree[last] ) last = rows[p];
+	}
+	return last;
+}
+
+#endif
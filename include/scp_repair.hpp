@@ -16,184 +16,68 @@
 #ifndef SCP_REPAIR_HPP
 #define SCP_REPAIR_HPP
 
-#include <vector>
-#include <set>
-#include <algorithm>
-#include "scp_problem.hpp"
+#include "scp_greedy.hpp"
+#include "scp_profile.hpp"
 
 /*
 	Class: scp_repair
 
 	Set Cover Problem solution repair using heuristics.
+
+	The construction is that of <scp_greedy>, from the partial solution
+	given to read(), with alpha = 1 by default (pure greedy). The solution
+	is sorted at the end of a run.
 */
-struct scp_repair
+struct scp_repair : scp_greedy
 {
 	scp_repair( double eps = 1e-9 );
 
-	void read( const scp_problem & instance );
-	void read( const std::vector<double> & c );
-	void read( const std::set<int> & x );
+	using scp_greedy::read;
+	void read( const scp_solution & x );
 	bool run();
-
-	double z() const;
-	std::set<int> x() const;
-
-	double alpha,
-	       epsilon;
-
-private:
-	std::vector<double> _c;
-	std::vector< std::set<int> > _S, _T;
-	std::set<int> _x;
-	double _z;
-
-	int _add( int i, std::vector<int> & u, std::vector<int> & v );
 };
 
 ////////////////////////////////////////////////////////////////////////////////
 
 inline scp_repair::scp_repair( double eps ) :
-	alpha( 1 ), epsilon( eps ), _z( 0 )
-{
-}
-
-inline void scp_repair::read( const scp_problem & instance )
-{
-	int m = instance.num_elements(),
-	    n = instance.num_sets();
-
-	std::set<int>::const_iterator it;
-
-	_c.clear();
-	_S.clear();
-	_T.clear();
-
-	_c = instance.c;
-	_S = instance.S;
-	_T.resize( m, std::set<int>() );
-
-	for ( int j = 0; j < n; ++j )
-	{
-		for ( it = instance.S[j].begin(); it != instance.S[j].end(); ++it )
-		{
-			_T[*it].insert( j );
-		}
-	}
-}
-
-inline void scp_repair::read( const std::vector<double> & c )
+	scp_greedy( 1, eps )
 {
-	_c = c;
 }
 
-inline void scp_repair::read( const std::set<int> & x )
+// Partial solution, see also x() to swap it in
+inline void scp_repair::read( const scp_solution & x )
 {
 	_x = x;
 }
 
 inline bool scp_repair::run()
 {
-	int m = _T.size(), n = _S.size();
+	int p = _x.size();
 
-	std::vector<int> u( m, 0 ), v( n, 0 );
-	std::set<int>::const_iterator it, jt, kt;
-	int num_covered = 0;
-	double c_min = std::numeric_limits<double>::infinity();
+	SCP_PROFILE_TIMER( repair_run );
+	SCP_PROFILE_COUNT( repair_runs );
 
-	_z = 0;
+	_reset();
 
-	for ( int i = 0; i < m; ++i )
+	for ( int k = 0; k < p; ++k )
 	{
-		u[i] = _T[i].size();
-
-		// Cope with negative of null costs
-		if ( _c[i] < c_min )
-		{
-			c_min = _c[i];
-		}
+		_uncovered -= _add( _x[k] );
 	}
 
-	for ( it = _x.begin(); it != _x.end(); ++it )
+	while ( _uncovered > 0 )
 	{
-		num_covered += _add( *it, u, v );
-	}
+		int k = 0, num_candidates = 0;
 
-	while ( num_covered < n )
-	{
-		std::vector<double> e( m, 0 );
-		std::vector<int> rcl;
-		double e_min = 0, e_max = 0, e_limit = 0;
-		int k;
-
-		for ( int i = 0; i < m; ++i )
-		{
-			if ( u[i] > 0 )
-			{
-				e[i] = double( u[i] ) / ( 1 + _c[i] - c_min );
-
-				if ( i > 0 )
-				{
-					if ( e[i] < e_min ) e_min = e[i];
-					if ( e[i] > e_max ) e_max = e[i];
-				}
-				else
-				{
-					e_min = e_max = e[i];
-				}
-			}
-		}
-
-		e_limit = e_min + alpha * ( e_max - e_min );
-
-		for ( int i = 0; i < m; ++i )
-		{
-			if ( u[i] > 0 && e[i] + epsilon >= e_limit )
-			{
-				rcl.push_back( i );
-			}
-		}
-
-		// Infeasible problem?
-		if ( rcl.empty() ) return false;
-
-		k = rcl[std::rand() % rcl.size()];
-		_x.insert( k );
-		num_covered += _add( k, u, v );
-	}
-	return true;
-}
+		if ( !_select( k, num_candidates ) ) return false;
 
-inline double scp_repair::z() const
-{
-	return _z;
-}
+		SCP_PROFILE_COUNT( repair_steps );
+		SCP_PROFILE_ADD( repair_candidates, num_candidates );
 
-inline std::set<int> scp_repair::x() const
-{
-	return _x;
-}
-
-inline int scp_repair::_add( int i, std::vector<int> & u, std::vector<int> & v )
-{
-	std::set<int>::const_iterator it, jt;
-	int n = 0;
-
-	_z += _c[i];
-
-	for ( jt = _T[i].begin(); jt != _T[i].end(); ++jt )
-	{
-		if ( v[*jt] == 0 )
-		{
-			++n;
-
-			for ( it = _S[*jt].begin(); it != _S[*jt].end(); ++it )
-			{
-				--u[*it];
-			}
-		}
-		++v[*jt];
+		_uncovered -= _add( k );
 	}
-	return n;
+
+	_x.sort();
+	return true;
 }
 
 #endif
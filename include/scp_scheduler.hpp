@@ -0,0 +1,195 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCP_SCHEDULER_HPP
+#define SCP_SCHEDULER_HPP
+
+#include <pthread.h>
+#include <vector>
+#include <limits>
+
+/*
+	Class: scp_scheduler
+
+	Work-stealing scheduler of tasks numbered from 0, such as the tries of
+	the metaheuristic, whose costs vary a lot.
+
+	The tasks are first split into one contiguous range per worker, taken
+	in order by its owner. A worker whose range is empty steals the upper
+	half of the largest remaining range, so that all the workers stay busy
+	until the last tasks. Each range has its own lock, which its owner
+	takes uncontended except during a steal.
+*/
+struct scp_scheduler
+{
+	scp_scheduler();
+	~scp_scheduler();
+
+	void start( int num_workers, int num_tasks );
+	bool next( int worker, int & task );
+	void stop();
+
+	bool stopped() const;
+	int steals() const;
+
+private:
+	struct range
+	{
+		pthread_mutex_t mutex;
+		int first, last;
+	};
+
+	std::vector<range *> _ranges;
+	volatile int _stopped, _steals;
+
+	void _clear();
+	int _remaining( int worker );
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline scp_scheduler::scp_scheduler() :
+	_stopped( 0 ), _steals( 0 )
+{
+}
+
+inline scp_scheduler::~scp_scheduler()
+{
+	_clear();
+}
+
+// Split the tasks among the workers, without limit if num_tasks <= 0
+inline void scp_scheduler::start( int num_workers, int num_tasks )
+{
+	long n = num_tasks > 0 ? num_tasks : std::numeric_limits<int>::max();
+
+	_clear();
+
+	if ( num_workers < 1 ) num_workers = 1;
+
+	for ( int w = 0; w < num_workers; ++w )
+	{
+		range * r = new range;
+
+		pthread_mutex_init( &r->mutex, 0 );
+		r->first = n * w / num_workers;
+		r->last = n * ( w + 1 ) / num_workers;
+
+		_ranges.push_back( r );
+	}
+
+	_stopped = 0;
+	_steals = 0;
+}
+
+// Next task of the worker, return false if there is none left anywhere
+inline bool scp_scheduler::next( int worker, int & task )
+{
+	range & own = *_ranges[worker];
+	int num_workers = _ranges.size();
+
+	pthread_mutex_lock( &own.mutex );
+	if ( !stopped() && own.first < own.last )
+	{
+		task = own.first++;
+		pthread_mutex_unlock( &own.mutex );
+		return true;
+	}
+	pthread_mutex_unlock( &own.mutex );
+
+	while ( !stopped() )
+	{
+		int victim = -1, size = 0, first = 0, last = 0;
+
+		for ( int w = 0; w < num_workers; ++w )
+		{
+			int s = ( w != worker ) ? _remaining( w ) : 0;
+
+			if ( s > size )
+			{
+				victim = w;
+				size = s;
+			}
+		}
+
+		if ( victim < 0 ) return false;
+
+		// The range may have shrunk since it was measured
+		range & r = *_ranges[victim];
+
+		pthread_mutex_lock( &r.mutex );
+		if ( r.first < r.last )
+		{
+			last = r.last;
+			first = r.last - ( r.last - r.first + 1 ) / 2;
+			r.last = first;
+		}
+		pthread_mutex_unlock( &r.mutex );
+
+		if ( first < last )
+		{
+			pthread_mutex_lock( &own.mutex );
+			own.first = first + 1;
+			own.last = last;
+			pthread_mutex_unlock( &own.mutex );
+
+			__sync_fetch_and_add( &_steals, 1 );
+			task = first;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Give no more tasks, such as when a stopping criterion is met
+inline void scp_scheduler::stop()
+{
+	__sync_lock_test_and_set( &_stopped, 1 );
+}
+
+inline bool scp_scheduler::stopped() const
+{
+	return __sync_fetch_and_add( const_cast<volatile int *>( &_stopped ), 0 ) != 0;
+}
+
+// Number of ranges stolen since start()
+inline int scp_scheduler::steals() const
+{
+	return __sync_fetch_and_add( const_cast<volatile int *>( &_steals ), 0 );
+}
+
+inline void scp_scheduler::_clear()
+{
+	for ( std::size_t w = 0; w < _ranges.size(); ++w )
+	{
+		pthread_mutex_destroy( &_ranges[w]->mutex );
+		delete _ranges[w];
+	}
+	_ranges.clear();
+}
+
+inline int scp_scheduler::_remaining( int worker )
+{
+	range & r = *_ranges[worker];
+	int size;
+
+	pthread_mutex_lock( &r.mutex );
+	size = r.last - r.first;
+	pthread_mutex_unlock( &r.mutex );
+
+	return size;
+}
+
+#endif
@@ -0,0 +1,429 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCP_SCORE_HPP
+#define SCP_SCORE_HPP
+
+#include <vector>
+#include <limits>
+#include <stdint.h>
+#include "scp_problem.hpp"
+
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#define SCP_SCORE_X86
+#include <immintrin.h>
+#endif
+
+/*
+	Class: scp_score
+
+	Greedy scoring kernel shared by <scp_grasp> and <scp_repair>: the
+	efficiency of a column i is u[i] / ( 1 + c[i] - c_min ), u[i] being the
+	number of rows it would cover, and only columns with u[i] > 0 are
+	candidates.
+
+	The denominators are inverted once by read(), and a scan is split in
+	two branch-free passes over u: <minmax> reduces the efficiencies of the
+	candidates, and <select> writes the candidates above a threshold (the
+	restricted candidate list), recomputing the efficiencies instead of
+	storing them.
+
+	The scans are vectorized with AVX2 or AVX-512 when the processor
+	supports them, selected at run time, with a scalar fallback. Since
+	<select> stores whole vectors of indices, it keeps <padding> extra
+	elements at the end of its output vector.
+
+	On integral costs, the denominators are also kept as int, with which
+	<exact_max> compares the efficiencies of the candidates of the best
+	one exactly, by cross-multiplication, so that the pure greedy choice
+	(alpha = 1) does not depend on the tolerance.
+*/
+struct scp_score
+{
+	enum isa_type
+	{
+		isa_scalar,
+		isa_avx2,
+		isa_avx512
+	};
+
+	enum { padding = 16 };
+
+	scp_score();
+
+	void read( const std::vector<double> & c );
+
+	bool isa( isa_type i );
+	isa_type isa() const;
+
+	static bool supported( isa_type i );
+	static isa_type best();
+	static const char * name( isa_type i );
+
+	int num_elements() const;
+	double c_min() const;
+
+	std::size_t memory() const;
+
+	bool minmax( const std::vector<int> & u, double & e_min, double & e_max ) const;
+	int select( const std::vector<int> & u, double threshold, std::vector<int> & rcl ) const;
+	int exact_max( const std::vector<int> & u, std::vector<int> & rcl, int n ) const;
+
+private:
+	typedef bool ( * minmax_type )( const int *, const double *, int, int, double &, double & );
+	typedef int ( * select_type )( const int *, const double *, int, int, double, int * );
+
+	std::vector<double> _r;
+	std::vector<int> _d;
+	double _c_min;
+	isa_type _isa;
+	minmax_type _minmax;
+	select_type _select;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Scalar kernels on the columns [first,m), also used for the tails of the
+// vector loops
+
+inline bool scp_score_minmax_scalar( const int * u, const double * r, int first, int m, double & e_min, double & e_max )
+{
+	double lo = std::numeric_limits<double>::infinity(), hi = 0;
+
+	for ( int i = first; i < m; ++i )
+	{
+		double e = u[i] * r[i];
+
+		if ( u[i] > 0 && e < lo ) lo = e;
+		if ( e > hi ) hi = e;
+	}
+
+	if ( lo < e_min ) e_min = lo;
+	if ( hi > e_max ) e_max = hi;
+	return e_max > 0;
+}
+
+inline int scp_score_select_scalar( const int * u, const double * r, int first, int m, double threshold, int * rcl )
+{
+	int n = 0;
+
+	for ( int i = first; i < m; ++i )
+	{
+		rcl[n] = i;
+		n += ( u[i] > 0 && u[i] * r[i] >= threshold );
+	}
+	return n;
+}
+
+#ifdef SCP_SCORE_X86
+
+// Lanes of the set bits of a 4-bit mask, packed at the start
+inline const __m128i * scp_score_lanes4()
+{
+	static const int lanes[16][4] __attribute__(( aligned( 16 ) )) =
+	{
+		{ 0, 0, 0, 0 }, { 0, 0, 0, 0 }, { 1, 0, 0, 0 }, { 0, 1, 0, 0 },
+		{ 2, 0, 0, 0 }, { 0, 2, 0, 0 }, { 1, 2, 0, 0 }, { 0, 1, 2, 0 },
+		{ 3, 0, 0, 0 }, { 0, 3, 0, 0 }, { 1, 3, 0, 0 }, { 0, 1, 3, 0 },
+		{ 2, 3, 0, 0 }, { 0, 2, 3, 0 }, { 1, 2, 3, 0 }, { 0, 1, 2, 3 }
+	};
+	return reinterpret_cast<const __m128i *>( lanes );
+}
+
+__attribute__(( target( "avx2" ) ))
+inline bool scp_score_minmax_avx2( const int * u, const double * r, int first, int m, double & e_min, double & e_max )
+{
+	const __m256d inf = _mm256_set1_pd( std::numeric_limits<double>::infinity() );
+	__m256d lo = inf, hi = _mm256_setzero_pd();
+	double lanes[4];
+	int i = first;
+
+	for ( ; i + 4 <= m; i += 4 )
+	{
+		__m128i ui = _mm_loadu_si128( reinterpret_cast<const __m128i *>( u + i ) );
+		__m256d e = _mm256_mul_pd( _mm256_cvtepi32_pd( ui ), _mm256_loadu_pd( r + i ) );
+		__m256d live = _mm256_castsi256_pd( _mm256_cvtepi32_epi64( _mm_cmpgt_epi32( ui, _mm_setzero_si128() ) ) );
+
+		// The exhausted columns have a null efficiency: masked for the
+		// minimum only
+		lo = _mm256_min_pd( lo, _mm256_blendv_pd( inf, e, live ) );
+		hi = _mm256_max_pd( hi, e );
+	}
+
+	_mm256_storeu_pd( lanes, lo );
+	for ( int k = 0; k < 4; ++k ) if ( lanes[k] < e_min ) e_min = lanes[k];
+	_mm256_storeu_pd( lanes, hi );
+	for ( int k = 0; k < 4; ++k ) if ( lanes[k] > e_max ) e_max = lanes[k];
+
+	return scp_score_minmax_scalar( u, r, i, m, e_min, e_max );
+}
+
+__attribute__(( target( "avx2,popcnt" ) ))
+inline int scp_score_select_avx2( const int * u, const double * r, int first, int m, double threshold, int * rcl )
+{
+	const __m128i * lanes = scp_score_lanes4();
+	const __m256d t = _mm256_set1_pd( threshold );
+	int i = first, n = 0;
+
+	for ( ; i + 4 <= m; i += 4 )
+	{
+		__m128i ui = _mm_loadu_si128( reinterpret_cast<const __m128i *>( u + i ) );
+		__m256d e = _mm256_mul_pd( _mm256_cvtepi32_pd( ui ), _mm256_loadu_pd( r + i ) );
+		__m256d live = _mm256_castsi256_pd( _mm256_cvtepi32_epi64( _mm_cmpgt_epi32( ui, _mm_setzero_si128() ) ) );
+		int mask = _mm256_movemask_pd( _mm256_and_pd( live, _mm256_cmp_pd( e, t, _CMP_GE_OQ ) ) );
+
+		// Compaction: the indices of the selected lanes are stored at the
+		// end of the list, the extra ones being overwritten later
+		_mm_storeu_si128( reinterpret_cast<__m128i *>( rcl + n ), _mm_add_epi32( _mm_set1_epi32( i ), lanes[mask] ) );
+		n += _mm_popcnt_u32( mask );
+	}
+
+	return n + scp_score_select_scalar( u, r, i, m, threshold, rcl + n );
+}
+
+__attribute__(( target( "avx512f,avx512vl,popcnt" ) ))
+inline bool scp_score_minmax_avx512( const int * u, const double * r, int first, int m, double & e_min, double & e_max )
+{
+	const __m512d inf = _mm512_set1_pd( std::numeric_limits<double>::infinity() );
+	__m512d lo = inf, hi = _mm512_setzero_pd();
+	double lanes[8];
+	int i = first;
+
+	for ( ; i + 8 <= m; i += 8 )
+	{
+		__m256i ui = _mm256_loadu_si256( reinterpret_cast<const __m256i *>( u + i ) );
+		__m512d e = _mm512_mul_pd( _mm512_maskz_cvtepi32_pd( 0xFF, ui ), _mm512_loadu_pd( r + i ) );
+		__mmask8 live = _mm256_cmpgt_epi32_mask( ui, _mm256_setzero_si256() );
+
+		// Masked minimum, see the AVX2 version
+		lo = _mm512_mask_min_pd( lo, live, lo, e );
+		hi = _mm512_mask_max_pd( hi, 0xFF, hi, e );
+	}
+
+	_mm512_storeu_pd( lanes, lo );
+	for ( int k = 0; k < 8; ++k ) if ( lanes[k] < e_min ) e_min = lanes[k];
+	_mm512_storeu_pd( lanes, hi );
+	for ( int k = 0; k < 8; ++k ) if ( lanes[k] > e_max ) e_max = lanes[k];
+
+	return scp_score_minmax_scalar( u, r, i, m, e_min, e_max );
+}
+
+__attribute__(( target( "avx512f,avx512vl,popcnt" ) ))
+inline int scp_score_select_avx512( const int * u, const double * r, int first, int m, double threshold, int * rcl )
+{
+	const __m512d t = _mm512_set1_pd( threshold );
+	const __m256i lanes = _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 );
+	int i = first, n = 0;
+
+	for ( ; i + 8 <= m; i += 8 )
+	{
+		__m256i ui = _mm256_loadu_si256( reinterpret_cast<const __m256i *>( u + i ) );
+		__m512d e = _mm512_mul_pd( _mm512_maskz_cvtepi32_pd( 0xFF, ui ), _mm512_loadu_pd( r + i ) );
+		__mmask8 live = _mm256_cmpgt_epi32_mask( ui, _mm256_setzero_si256() ),
+		         mask = _mm512_mask_cmp_pd_mask( live, e, t, _CMP_GE_OQ );
+
+		_mm256_mask_compressstoreu_epi32( rcl + n, mask, _mm256_add_epi32( _mm256_set1_epi32( i ), lanes ) );
+		n += _mm_popcnt_u32( mask );
+	}
+
+	return n + scp_score_select_scalar( u, r, i, m, threshold, rcl + n );
+}
+
+#endif
+
+inline scp_score::scp_score() :
+	_c_min( 0 )
+{
+	isa( best() );
+}
+
+inline void scp_score::read( const std::vector<double> & c )
+{
+	int m = c.size();
+
+	_c_min = std::numeric_limits<double>::infinity();
+
+	// Cope with negative of null costs
+	for ( int i = 0; i < m; ++i )
+	{
+		if ( c[i] < _c_min )
+		{
+			_c_min = c[i];
+		}
+	}
+
+	_r.resize( m );
+
+	for ( int i = 0; i < m; ++i )
+	{
+		_r[i] = 1 / ( 1 + c[i] - _c_min );
+	}
+
+	// Below 2^30 + 1, since the integral costs are in ( -2^29, 2^29 )
+	_d.clear();
+	if ( scp_integral( c ) )
+	{
+		_d.resize( m );
+
+		for ( int i = 0; i < m; ++i )
+		{
+			_d[i] = int( 1 + c[i] - _c_min );
+		}
+	}
+}
+
+// Select the kernels, returns false if not supported by the processor
+inline bool scp_score::isa( isa_type i )
+{
+	if ( !supported( i ) )
+	{
+		return false;
+	}
+
+	_isa = i;
+	_minmax = scp_score_minmax_scalar;
+	_select = scp_score_select_scalar;
+
+#ifdef SCP_SCORE_X86
+	if ( i == isa_avx2 )
+	{
+		_minmax = scp_score_minmax_avx2;
+		_select = scp_score_select_avx2;
+	}
+	else if ( i == isa_avx512 )
+	{
+		_minmax = scp_score_minmax_avx512;
+		_select = scp_score_select_avx512;
+	}
+#endif
+	return true;
+}
+
+inline scp_score::isa_type scp_score::isa() const
+{
+	return _isa;
+}
+
+inline bool scp_score::supported( isa_type i )
+{
+#ifdef SCP_SCORE_X86
+	__builtin_cpu_init();
+
+	switch ( i )
+	{
+		case isa_scalar:
+			return true;
+		case isa_avx2:
+			return __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "popcnt" );
+		case isa_avx512:
+			return __builtin_cpu_supports( "avx512f" ) && __builtin_cpu_supports( "avx512vl" )
+			    && __builtin_cpu_supports( "popcnt" );
+	}
+	return false;
+#else
+	return i == isa_scalar;
+#endif
+}
+
+inline scp_score::isa_type scp_score::best()
+{
+	static const isa_type i = supported( isa_avx512 ) ? isa_avx512
+	                        : supported( isa_avx2 ) ? isa_avx2 : isa_scalar;
+	return i;
+}
+
+inline const char * scp_score::name( isa_type i )
+{
+	switch ( i )
+	{
+		case isa_scalar: return "scalar";
+		case isa_avx2:   return "avx2";
+		case isa_avx512: return "avx512";
+	}
+	return "";
+}
+
+inline int scp_score::num_elements() const
+{
+	return _r.size();
+}
+
+inline double scp_score::c_min() const
+{
+	return _c_min;
+}
+
+// Number of bytes used
+inline std::size_t scp_score::memory() const
+{
+	return sizeof( *this ) + _r.capacity() * sizeof( double ) + _d.capacity() * sizeof( int );
+}
+
+// Minimum and maximum efficiencies of the candidates, returns false if
+// there is none
+inline bool scp_score::minmax( const std::vector<int> & u, double & e_min, double & e_max ) const
+{
+	e_min = std::numeric_limits<double>::infinity();
+	e_max = 0;
+	return !_r.empty() && _minmax( &u[0], &_r[0], 0, _r.size(), e_min, e_max );
+}
+
+// Write the candidates whose efficiency is at least threshold at the start
+// of rcl, and return their number. The size of rcl is only increased on
+// the first call
+inline int scp_score::select( const std::vector<int> & u, double threshold, std::vector<int> & rcl ) const
+{
+	if ( rcl.size() < _r.size() + padding )
+	{
+		rcl.resize( _r.size() + padding );
+	}
+	return _r.empty() ? 0 : _select( &u[0], &_r[0], 0, _r.size(), threshold, &rcl[0] );
+}
+
+// Keep the candidates rcl[0,n) of the largest efficiency, compared exactly
+// if the costs are integral (u[i] / d[i] > u[k] / d[k] if and only if
+// u[i] * d[k] > u[k] * d[i], on 64 bits), and return their number
+inline int scp_score::exact_max( const std::vector<int> & u, std::vector<int> & rcl, int n ) const
+{
+	int64_t u_max = 0, d_max = 1;
+	int k = 0;
+
+	if ( _d.empty() )
+	{
+		return n;
+	}
+
+	for ( int p = 0; p < n; ++p )
+	{
+		int i = rcl[p];
+
+		if ( int64_t( u[i] ) * d_max > u_max * _d[i] )
+		{
+			u_max = u[i];
+			d_max = _d[i];
+		}
+	}
+
+	for ( int p = 0; p < n; ++p )
+	{
+		int i = rcl[p];
+
+		rcl[k] = i;
+		k += ( int64_t( u[i] ) * d_max == u_max * _d[i] );
+	}
+	return k;
+}
+
+#endif
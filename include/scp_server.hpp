@@ -0,0 +1,84 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCP_SERVER_HPP
+#define SCP_SERVER_HPP
+
+#include <pthread.h>
+#include <string>
+#include <deque>
+#include <set>
+#include "scp_batch.hpp"
+
+/*
+	Class: scp_server
+
+	Daemon mode: solves the instances sent on a Unix domain socket with a
+	pool of worker threads. Each worker keeps its solvers and instance
+	between requests, and serves one connection at a time.
+
+	A connection is a sequence of requests, each one being a header line
+	followed by the instance data:
+
+	> SOLVE bytes=N [KEY=VALUE ...]
+	> <N bytes: instance in the scp, rail, stn or binary format>
+
+	The parameters are those of the batch manifest (format, alpha, n, seed,
+	time-limit, target, ...), with the command line options as defaults.
+	The reply is either:
+
+	> OK z=Z iterations=K time=T columns=P
+	> <P columns of the cover, starting from 1>
+
+	or "ERROR message". "PING" replies "OK", and "QUIT" closes the
+	connection. The connection is also closed after the error of a request
+	whose data cannot be read, having no size or one above <max_bytes>, or
+	a header line longer than <max_line>, and when the client sends nothing
+	for <timeout> seconds.
+*/
+struct scp_server
+{
+	scp_server();
+	~scp_server();
+
+	bool listen( const std::string & path );
+	void run( int num_threads, const scp_batch_job & defaults );
+
+	// Largest instance data accepted in a request, largest header line,
+	// and time without data after which a connection is closed (0 for
+	// none)
+	long max_bytes;
+	std::size_t max_line;
+	double timeout;
+
+private:
+	std::string _path;
+	int _socket;
+	scp_batch_job _defaults;
+
+	std::deque<int> _connections;
+	std::set<int> _active;
+	bool _closing;
+
+	pthread_mutex_t _mutex;
+	pthread_cond_t _cond;
+
+	static void * _worker( void * self );
+
+	void _work();
+	bool _pop( int & fd );
+};
+
+#endif
@@ -0,0 +1,213 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCP_SOLUTION_HPP
+#define SCP_SOLUTION_HPP
+
+#include <vector>
+#include <algorithm>
+
+/*
+	Class: scp_solution
+
+	Set of selected columns: a contiguous list of the columns and the
+	position of each column in the list (-1 if not selected), giving
+	membership, insertion and removal in constant time.
+
+	Removal moves the last column into the freed position, so the list is
+	only sorted after <sort>. Copies and <clear> cost the number of
+	selected columns, and swap() exchanges two solutions without copy.
+*/
+struct scp_solution
+{
+	typedef std::vector<int>::const_iterator const_iterator;
+
+	scp_solution();
+	explicit scp_solution( int m );
+	scp_solution( const scp_solution & x );
+
+	scp_solution & operator = ( const scp_solution & x );
+
+	void resize( int m );
+	void clear();
+	void swap( scp_solution & x );
+
+	int num_elements() const;
+	int size() const;
+	bool empty() const;
+
+	bool contains( int i ) const;
+	bool insert( int i );
+	bool erase( int i );
+	void sort();
+
+	int operator [] ( int p ) const;
+	const_iterator begin() const;
+	const_iterator end() const;
+
+	std::size_t memory() const;
+
+private:
+	std::vector<int> _columns, _position;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline scp_solution::scp_solution()
+{
+}
+
+inline scp_solution::scp_solution( int m )
+{
+	resize( m );
+}
+
+inline scp_solution::scp_solution( const scp_solution & x )
+{
+	*this = x;
+}
+
+// Allocates only if the number of columns differs
+inline scp_solution & scp_solution::operator = ( const scp_solution & x )
+{
+	if ( this == &x )
+	{
+		return *this;
+	}
+
+	if ( num_elements() != x.num_elements() )
+	{
+		resize( x.num_elements() );
+	}
+	else
+	{
+		clear();
+	}
+
+	_columns.assign( x._columns.begin(), x._columns.end() );
+
+	for ( int p = 0; p < size(); ++p )
+	{
+		_position[_columns[p]] = p;
+	}
+	return *this;
+}
+
+// Empty solution on m columns
+inline void scp_solution::resize( int m )
+{
+	_columns.clear();
+	_columns.reserve( m );
+	_position.assign( m, -1 );
+}
+
+inline void scp_solution::clear()
+{
+	for ( std::size_t p = 0; p < _columns.size(); ++p )
+	{
+		_position[_columns[p]] = -1;
+	}
+	_columns.clear();
+}
+
+inline void scp_solution::swap( scp_solution & x )
+{
+	_columns.swap( x._columns );
+	_position.swap( x._position );
+}
+
+inline int scp_solution::num_elements() const
+{
+	return _position.size();
+}
+
+inline int scp_solution::size() const
+{
+	return _columns.size();
+}
+
+inline bool scp_solution::empty() const
+{
+	return _columns.empty();
+}
+
+inline bool scp_solution::contains( int i ) const
+{
+	return _position[i] >= 0;
+}
+
+// Returns false if the column was already selected
+inline bool scp_solution::insert( int i )
+{
+	if ( _position[i] >= 0 )
+	{
+		return false;
+	}
+
+	_position[i] = _columns.size();
+	_columns.push_back( i );
+	return true;
+}
+
+// Returns false if the column was not selected
+inline bool scp_solution::erase( int i )
+{
+	int p = _position[i];
+
+	if ( p < 0 )
+	{
+		return false;
+	}
+
+	_columns[p] = _columns.back();
+	_position[_columns[p]] = p;
+	_columns.pop_back();
+	_position[i] = -1;
+	return true;
+}
+
+// Sort the list of columns, for a canonical order
+inline void scp_solution::sort()
+{
+	std::sort( _columns.begin(), _columns.end() );
+
+	for ( std::size_t p = 0; p < _columns.size(); ++p )
+	{
+		_position[_columns[p]] = p;
+	}
+}
+
+inline int scp_solution::operator [] ( int p ) const
+{
+	return _columns[p];
+}
+
+inline scp_solution::const_iterator scp_solution::begin() const
+{
+	return _columns.begin();
+}
+
+inline scp_solution::const_iterator scp_solution::end() const
+{
+	return _columns.end();
+}
+
+// Number of bytes used
+inline std::size_t scp_solution::memory() const
+{
+	return sizeof( *this ) + ( _columns.capacity() + _position.capacity() ) * sizeof( int );
+}
+
+#endif
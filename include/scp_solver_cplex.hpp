@@ -18,25 +18,26 @@
 
 #include <ilcplex/ilocplex.h>
 #include <vector>
-#include <set>
 #include "scp_problem.hpp"
 
 /*
 	Class: scp_solver_cplex
 
-	Set Cover Problem solver.
+	Set Cover Problem solver, or of its linear relaxation, whose dual
+	values give the reduced costs of the columns (see <scp_lp>).
 */
 struct scp_solver_cplex
 {
 	scp_solver_cplex();
 
-	void read( const scp_problem & instance );
+	void read( const scp_problem & instance, bool relaxed = false );
 	bool run();
 
 	double z() const;
-	std::set<int> x() const;
+	std::vector<int> x() const;
+	std::vector<double> duals() const;
 
-	void cut( const std::set<int> & x );
+	void cut( const std::vector<int> & x );
 
 	void verbose();
 	void quiet();
@@ -0,0 +1,158 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCP_STOP_HPP
+#define SCP_STOP_HPP
+
+#include <limits>
+#include "chrono.hpp"
+
+/*
+	Class: scp_stop
+
+	Stopping criteria of the metaheuristic main loop: number of iterations,
+	time limit, target objective value and number of iterations without
+	improvement. A null (or negative) limit means no limit.
+
+	<expired> only reads the clock, so that it can be polled inside long
+	local searches.
+*/
+struct scp_stop
+{
+	scp_stop();
+
+	void start();
+	bool update( double z );
+	bool improve( double z );
+
+	bool done() const;
+	bool expired() const;
+
+	double elapsed() const;
+	int iterations() const;
+	double best() const;
+
+	bool target_reached() const;
+	double time_to_target() const;
+	int iterations_to_target() const;
+
+	int max_iterations,
+	    stall_iterations;
+	double time_limit,
+	       target,
+	       epsilon;
+
+private:
+	chrono::time_point _begin;
+	int _iterations, _last_improvement, _iterations_to_target;
+	double _best, _time_to_target;
+	bool _target_reached;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline scp_stop::scp_stop() :
+	max_iterations( 0 ),
+	stall_iterations( 0 ),
+	time_limit( 0 ),
+	target( -std::numeric_limits<double>::infinity() ),
+	epsilon( 1e-9 )
+{
+	start();
+}
+
+inline void scp_stop::start()
+{
+	_begin = chrono::now();
+	_iterations = 0;
+	_last_improvement = 0;
+	_iterations_to_target = 0;
+	_best = std::numeric_limits<double>::infinity();
+	_time_to_target = 0;
+	_target_reached = false;
+}
+
+// Record the objective value of an iteration, return true on improvement
+inline bool scp_stop::update( double z )
+{
+	++_iterations;
+	return improve( z );
+}
+
+// Record an objective value found outside of the iterations, such as by
+// another process, return true on improvement
+inline bool scp_stop::improve( double z )
+{
+	bool improved = z < _best - epsilon;
+
+	if ( improved )
+	{
+		_best = z;
+		_last_improvement = _iterations;
+	}
+
+	if ( !_target_reached && z <= target + epsilon )
+	{
+		_target_reached = true;
+		_time_to_target = elapsed();
+		_iterations_to_target = _iterations;
+	}
+	return improved;
+}
+
+inline bool scp_stop::done() const
+{
+	return _target_reached
+	    || ( max_iterations > 0 && _iterations >= max_iterations )
+	    || ( stall_iterations > 0 && _iterations - _last_improvement >= stall_iterations )
+	    || expired();
+}
+
+inline bool scp_stop::expired() const
+{
+	return time_limit > 0 && elapsed() >= time_limit;
+}
+
+inline double scp_stop::elapsed() const
+{
+	return chrono::now() - _begin;
+}
+
+inline int scp_stop::iterations() const
+{
+	return _iterations;
+}
+
+inline double scp_stop::best() const
+{
+	return _best;
+}
+
+inline bool scp_stop::target_reached() const
+{
+	return _target_reached;
+}
+
+inline double scp_stop::time_to_target() const
+{
+	return _time_to_target;
+}
+
+inline int scp_stop::iterations_to_target() const
+{
+	return _iterations_to_target;
+}
+
+#endif
@@ -15,76 +15,94 @@
 
 #include "scp_problem.hpp"
 #include "scp_solver_cplex.hpp"
-#include "scp_grasp.hpp"
-#include "scp_local_search.hpp"
+#include "scp_driver.hpp"
+#include "scp_batch.hpp"
+#include "scp_server.hpp"
+#include "scp_island.hpp"
+#include "scp_parallel.hpp"
+#include "scp_io.hpp"
+#include "scp_score.hpp"
+#include "scp_profile.hpp"
+#include "scp_memory.hpp"
+#include "scp_renumber.hpp"
+#include "scp_lp.hpp"
 #include "chrono.hpp"
-#include "gzfstream.hpp"
 #include "docopt.hpp"
 #include <iostream>
 #include <fstream>
-#include <sstream>
 #include <string>
 #include <limits>
 #include <stdexcept>
-#include <cstdlib>
 #include <ctime>
 
-enum
-{
-	format_scp,
-	format_rail,
-	format_stn
-};
-
-void read_instance( int format, std::istream & is, scp_problem & instance )
-{
-	switch ( format )
-	{
-		case format_rail:
-			instance.read_rail( is );
-			break;
-		case format_stn:
-			instance.read_stn( is );
-			break;
-		case format_scp:
-		default:
-			instance.read( is );
-			break;
-	};
-}
-
 int main( int argc, char * argv[] )
 {
 	docopt::option_group options;
 	docopt::parser opt_parser;
 
-	int num_runs = 100, format = format_scp;
-	double alpha = 0.9, epsilon = 1e-9;
+	int num_runs = 100, block = 20, stall_iterations = 0, num_threads = 1, level = -1, verify = 0,
+	    migration = 10, max_request = 1024;
+	double alpha = 0.9, epsilon = 1e-9, time_limit = 0, idle = 60,
+	       target = -std::numeric_limits<double>::infinity();
 	unsigned int seed = std::time( 0 );
-	bool verbose = true, help = false;
-	std::string format_str, filename;
+	bool verbose = true, help = false, reactive = false, numa = false, fix = false;
+	std::string format_str, clock_str = "wall", pages_str = "normal", order_str, bound_str = "mip", score_str = "cost", filename, batch_filename, socket_path,
+	            incumbents_filename, solution_filename, pool_filename, stats_filename, instance_filename, island_name,
+	            alphas = "0.1,0.2,0.3,0.4,0.5,0.6,0.7,0.8,0.9,1";
+	scp_format format = format_scp;
+	scp_order order = order_none;
 
-	double z_opt = 0,
-	       min_gap = std::numeric_limits<double>::infinity(),
-	       max_gap = 0,
-	       sum_gap = 0;
+	double total_time = 0;
+	int num_iterations = 0;
 
 	scp_problem instance;
+	scp_index index;
+	scp_renumbering renumbering;
+	scp_island island;
+	scp_parallel parallel;
 	scp_solver_cplex cplex;
-	scp_grasp grasp( alpha, epsilon );
-	scp_local_search local_search;
-
-	chrono::time_point begin, end;
+	scp_lp lp;
+	std::vector<double> weights;
+	scp_driver driver;
+	scp_batch_job defaults;
+	scp_ofstream incumbents_file, pool_file;
 
 	// Initialize option parser
 
 	options.name( "Options:" )
 		( "alpha",   'a', "FLOAT",  "RCL threshold parameter (in [0,1])" )
-		(            'n', "INT",    "Number of tries" )
+		(            'n', "INT",    "Number of tries (0 for no limit)" )
 		( "random",  'r', "INT",    "Random seed" )
 		( "epsilon", 'e', "FLOAT",  "Tolerance" )
-		( "format",  'f', "FORMAT", "Instance file format (scp, rail, stn)" )
+		( "format",  'f', "FORMAT", "Instance file format (scp, rail, stn, binary)" )
 		( "quiet",   'q',           "Don't produce any verbose output" )
+		( "reactive",               "Select alpha with Reactive GRASP" )
+		( "alphas",       "LIST",   "Reactive GRASP alpha values (comma-separated)" )
+		( "block",        "INT",    "Reactive GRASP probability update period" )
+		( "stats",        "FILE",   "Write the Reactive GRASP statistics of each alpha at the end" )
+		( "time-limit",   "FLOAT",  "Stop after the given number of seconds" )
+		( "target",       "FLOAT",  "Stop when the given objective value is reached, and compute the gaps to it" )
+		( "bound",        "BOUND",  "Reference of the gaps (mip, lp, lagrangian)" )
+		( "fix",                    "Remove the columns fixed by reduced cost (with --bound=lp or lagrangian)" )
+		( "score",        "SCORE",  "GRASP column score (cost, dual: reduced cost)" )
+		( "stall-iterations", "INT", "Stop after the given number of tries without improvement" )
+		( "clock",        "CLOCK",  "Clock used to measure time (wall, process, thread, tsc)" )
+		( "verify",       "INT",    "Fully check the solutions every INT tries (0 for never)" )
+		( "incumbents",   "FILE",   "Write each improved solution ('-' for stdout)" )
+		( "solution",     "FILE",   "Write the best solution at the end" )
+		( "pool",         "FILE",   "Write all the local search solutions" )
+		( "write-instance", "FILE", "Write the instance (binary if FILE ends with .bin)" )
+		( "renumber",     "ORDER",  "Renumber the rows and columns (none, cost, rcm)" )
+		( "level",        "INT",    "Compression level of the .gz output files (0-9)" )
+		( "batch",        "FILE",   "Solve the jobs listed in a manifest ('-' for stdin)" )
+		( "listen",       "PATH",   "Serve the requests of a Unix domain socket" )
+		( "max-request",  "INT",    "Largest instance accepted by the server, in MB" )
+		( "idle",         "FLOAT",  "Close the server connections idle for the given number of seconds (0 for never)" )
+		( "threads", 'j', "INT",    "Number of worker threads" )
+		( "numa",                   "Pin the threads and replicate the instance per NUMA node" )
+		( "huge-pages",   "PAGES",  "Pages of the large arrays (normal, thp, explicit)" )
+		( "island",       "NAME",   "Share the instance and the best solutions with the processes of the same island NAME" )
+		( "migration",    "INT",    "Exchange the best solutions between islands every INT tries" )
 		( docopt::option::help() );
 
 	opt_parser
@@ -95,6 +113,33 @@ int main( int argc, char * argv[] )
 		.bind( 'e', &epsilon )
 		.bind( 'f', &format_str )
 		.bind<bool, false>( 'q', &verbose )
+		.bind( "reactive", &reactive )
+		.bind( "alphas", &alphas )
+		.bind( "block", &block )
+		.bind( "stats", &stats_filename )
+		.bind( "time-limit", &time_limit )
+		.bind( "target", &target )
+		.bind( "bound", &bound_str )
+		.bind( "fix", &fix )
+		.bind( "score", &score_str )
+		.bind( "stall-iterations", &stall_iterations )
+		.bind( "clock", &clock_str )
+		.bind( "verify", &verify )
+		.bind( "incumbents", &incumbents_filename )
+		.bind( "solution", &solution_filename )
+		.bind( "pool", &pool_filename )
+		.bind( "write-instance", &instance_filename )
+		.bind( "renumber", &order_str )
+		.bind( "level", &level )
+		.bind( "batch", &batch_filename )
+		.bind( "listen", &socket_path )
+		.bind( "max-request", &max_request )
+		.bind( "idle", &idle )
+		.bind( 'j', &num_threads )
+		.bind( "numa", &numa )
+		.bind( "huge-pages", &pages_str )
+		.bind( "island", &island_name )
+		.bind( "migration", &migration )
 		.bind( '?', &help )
 		.bind_arguments( &filename );
 
@@ -102,10 +147,12 @@ int main( int argc, char * argv[] )
 
 	// Print help
 
-	if ( help || filename.empty() )
+	if ( help || ( filename.empty() && batch_filename.empty() && socket_path.empty() ) )
 	{
 		std::cout
 			<< "Usage: " << argv[0] << " [OPTIONS] FILE" << std::endl
+			<< "       " << argv[0] << " [OPTIONS] --batch=FILE" << std::endl
+			<< "       " << argv[0] << " [OPTIONS] --listen=PATH" << std::endl
 			<< std::endl
 			<< options << std::endl;
 		return 0;
@@ -113,193 +160,656 @@ int main( int argc, char * argv[] )
 
 	// Select format
 
-	if ( format_str == "rail" )
+	if ( !scp_format_parse( format_str, format ) )
 	{
-		format = format_rail;
+		std::cerr << "Error: unknown format '" << format_str << "'" << std::endl;
+		return 0;
 	}
-	else if ( format_str == "stn" )
+
+	// Select bound
+
+	if ( bound_str != "mip" && bound_str != "lp" && bound_str != "lagrangian" )
 	{
-		format = format_stn;
+		std::cerr << "Error: unknown bound '" << bound_str << "'" << std::endl;
+		return 0;
+	}
+
+	// Select score
+
+	if ( score_str != "cost" && score_str != "dual" )
+	{
+		std::cerr << "Error: unknown score '" << score_str << "'" << std::endl;
+		return 0;
+	}
+
+	if ( ( fix || score_str == "dual" ) && bound_str == "mip" )
+	{
+		std::cerr << "Error: fixing and dual scores need the duals of --bound=lp or lagrangian" << std::endl;
+		return 0;
+	}
+
+	if ( ( fix || score_str == "dual" ) && !island_name.empty() )
+	{
+		std::cerr << "Error: islands cannot fix nor score the columns by reduced cost" << std::endl;
+		return 0;
+	}
+
+	// Select order
+
+	if ( !scp_order_parse( order_str, order ) )
+	{
+		std::cerr << "Error: unknown order '" << order_str << "'" << std::endl;
+		return 0;
+	}
+
+	if ( order != order_none && !island_name.empty() )
+	{
+		std::cerr << "Error: islands cannot renumber the instance" << std::endl;
+		return 0;
+	}
+
+	// Select clock
+
+	if ( !chrono::clock( clock_str ) )
+	{
+		std::cerr << "Error: unknown clock '" << clock_str << "'" << std::endl;
+		return 0;
+	}
+
+#ifdef SCP_PROFILE
+	// Calibrate the time stamp counter of the profile timers before any
+	// thread starts, as chrono::clock() does for the tsc clock
+	chrono::tsc_frequency();
+#endif
+
+	// The threads of a single run share its time limit, which the CPU
+	// times of different threads cannot measure
+	if ( chrono::clock() == chrono::thread && num_threads > 1 && batch_filename.empty() && socket_path.empty() )
+	{
+		std::cerr << "Error: the thread clock cannot time a run on several threads" << std::endl;
+		return 0;
+	}
+
+	// Select pages, before any large allocation
+
+	if ( !scp_memory::pages( pages_str ) )
+	{
+		std::cerr << "Error: unknown pages '" << pages_str << "'" << std::endl;
+		return 0;
+	}
+
+	if ( !( alpha >= 0 && alpha <= 1 ) )
+	{
+		std::cerr << "Error: alpha must be in [0,1]" << std::endl;
+		return 0;
+	}
+
+	// Batch and server modes: the options are the defaults of the jobs
+
+	defaults.format = format;
+	defaults.alpha = alpha;
+	defaults.epsilon = epsilon;
+	defaults.time_limit = time_limit;
+	defaults.target = target;
+	defaults.num_runs = num_runs;
+	defaults.stall_iterations = stall_iterations;
+	defaults.block = block;
+	defaults.verify = verify;
+	defaults.seed = seed;
+	defaults.reactive = reactive;
+	defaults.alphas = alphas;
+
+	if ( !socket_path.empty() )
+	{
+		scp_server server;
+
+		server.max_bytes = long( max_request ) << 20;
+		server.timeout = idle;
+
+		if ( server.listen( socket_path ) )
+		{
+			server.run( num_threads, defaults );
+
+#ifdef SCP_PROFILE
+			scp_profile::write( std::clog );
+#endif
+		}
+		return 0;
+	}
+
+	if ( !batch_filename.empty() )
+	{
+		scp_batch batch;
+		bool ok = false;
+
+		if ( batch_filename != "-" )
+		{
+			std::ifstream file( batch_filename.c_str() );
+			if ( !file.is_open() )
+			{
+				std::cerr << "Error opening '" << batch_filename << "'" << std::endl;
+				return 0;
+			}
+			ok = batch.read( file, defaults );
+		}
+		else
+		{
+			ok = batch.read( std::cin, defaults );
+		}
+
+		if ( ok )
+		{
+			batch.run( num_threads, std::cout );
+
+#ifdef SCP_PROFILE
+			scp_profile::write( std::clog );
+#endif
+		}
+		return 0;
 	}
 
 	// Print options
 
 	if ( verbose )
 	{
-		switch ( format )
-		{
-			case format_rail:
-				std::cout << "format  = rail" << std::endl;
-				break;
-			case format_stn:
-				std::cout << "format  = stn" << std::endl;
-				break;
-			case format_scp:
-			default:
-				std::cout << "format  = scp" << std::endl;
-				break;
-		};
+		std::cout << "format  = " << scp_format_name( format ) << std::endl;
+		if ( reactive )
+		{
+			std::cout
+				<< "alphas  = " << alphas << std::endl
+				<< "block   = " << block << std::endl;
+		}
+		else
+		{
+			std::cout << "alpha   = " << alpha << std::endl;
+		}
 		std::cout
-			<< "alpha   = " << alpha << std::endl
 			<< "n       = " << num_runs << std::endl
 			<< "random  = " << seed << std::endl
-			<< "epsilon = " << epsilon << std::endl;
+			<< "threads = " << num_threads << std::endl
+			<< "epsilon = " << epsilon << std::endl
+			<< "clock   = " << chrono::name( chrono::clock() ) << std::endl
+			<< "simd    = " << scp_score::name( scp_score::best() ) << std::endl
+			<< "pages   = " << scp_memory::name( scp_memory::pages() ) << std::endl;
+		if ( order != order_none )
+		{
+			std::cout << "order   = " << scp_order_name( order ) << std::endl;
+		}
+		if ( bound_str != "mip" )
+		{
+			std::cout << "bound   = " << bound_str << std::endl
+			          << "fix     = " << fix << std::endl
+			          << "score   = " << score_str << std::endl;
+		}
+		if ( time_limit > 0 )
+		{
+			std::cout << "time    = " << time_limit << std::endl;
+		}
+		if ( target > -std::numeric_limits<double>::infinity() )
+		{
+			std::cout << "target  = " << target << std::endl;
+		}
+		if ( stall_iterations > 0 )
+		{
+			std::cout << "stall   = " << stall_iterations << std::endl;
+		}
+		if ( verify > 0 )
+		{
+			std::cout << "verify  = " << verify << std::endl;
+		}
+		if ( !island_name.empty() )
+		{
+			std::cout
+				<< "island  = " << island_name << std::endl
+				<< "migrate = " << migration << std::endl;
+		}
 	}
 
-	// Initialize random number generator
+	if ( num_runs <= 0 && time_limit <= 0 && stall_iterations <= 0
+	  && target == -std::numeric_limits<double>::infinity() )
+	{
+		std::cerr << "Error: no stopping criterion" << std::endl;
+		return 0;
+	}
 
-	std::srand( seed );
+	// Initialize the metaheuristic
 
-	// Initialize GRASP
+	driver.alpha = alpha;
+	driver.epsilon = epsilon;
+	driver.reactive = reactive;
+	driver.verify = verify;
+	driver.log = verbose ? &std::cout : 0;
+	driver.seed( seed );
 
-	grasp.alpha = alpha;
-	grasp.epsilon = epsilon;
+	if ( reactive )
+	{
+		driver.reactive_alpha.block = block;
+		driver.reactive_alpha.read( alphas );
 
-	// Open and load the instance file
+		if ( driver.reactive_alpha.size() == 0 )
+		{
+			std::cerr << "Error: no valid alpha value in '" << alphas << "'" << std::endl;
+			return 0;
+		}
+	}
+	else if ( !stats_filename.empty() )
+	{
+		std::cerr << "Error: statistics of alpha without --reactive" << std::endl;
+		return 0;
+	}
+
+	// Open the streams of solutions
 
-	if ( filename.substr( filename.find_last_of( "." ) + 1 ) == "gz" )
+	if ( !incumbents_filename.empty() )
 	{
-		// Read gzip compressed instance
-		gz::ifstream file( filename.c_str() );
-		if ( !file.is_open() )
+		if ( !incumbents_file.open( incumbents_filename, level ) )
 		{
-			std::cerr << "Error opening '" << filename << "'" << std::endl;
+			std::cerr << "Error opening '" << incumbents_filename << "'" << std::endl;
 			return 0;
 		}
-		read_instance( format, file, instance );
-		file.close();
+		driver.incumbents = &incumbents_file;
 	}
-	else if ( filename != "-" )
+
+	if ( !pool_filename.empty() )
 	{
-		// Read uncompressed instance from file
-		std::ifstream file( filename.c_str() );
-		if ( !file.is_open() )
+		if ( !pool_file.open( pool_filename, level ) )
 		{
-			std::cerr << "Error opening '" << filename << "'" << std::endl;
+			std::cerr << "Error opening '" << pool_filename << "'" << std::endl;
 			return 0;
 		}
-		read_instance( format, file, instance );
-		file.close();
+		driver.pool = &pool_file;
 	}
-	else
+
+	// Island mode: the first process loads the instance, the other ones
+	// wait for it to be published
+
+	if ( !island_name.empty() && !island.create( island_name ) )
 	{
-		// Read uncompressed instance from terminal
-		read_instance( format, std::cin, instance );
+		if ( !island.attach( island_name ) )
+		{
+			std::cerr << "Error: island '" << island_name << "' not published"
+			          << " (remove /dev/shm/" << island_name << " if left by a crash)" << std::endl;
+			return 0;
+		}
+
+		if ( !island.holds( filename ) )
+		{
+			std::cerr << "Error: island '" << island_name << "' holds another instance than '" << filename << "'"
+			          << " (remove /dev/shm/" << island_name << " if left by a crash)" << std::endl;
+			return 0;
+		}
+
+		driver.read( island.instance(), island.index() );
+		driver.z_ref = island.z_ref();
+
+		if ( verbose )
+		{
+			std::cout << "Island: " << island.id() << " | shared = " << island.size() / 1048576. << " MB"
+			          << " | solvers = " << driver.memory() / 1048576. << " MB" << std::endl;
+
+			if ( scp_memory::pages() != scp_memory::normal )
+			{
+				scp_memory::write( std::cout );
+			}
+		}
 	}
 
-	if ( verbose )
+	// Open and load the instance file
+
+	if ( !island.joined() && !scp_load( filename, format, instance ) )
+	{
+		std::cerr << "Error reading '" << filename << "'" << std::endl;
+		return 0;
+	}
+
+	if ( verbose && !island.joined() )
 	{
 		std::cout << "Number of elements: " << instance.num_elements() << std::endl;
 		std::cout << "Number of sets: " << instance.num_sets() << std::endl;
 	}
 
+	if ( !island.joined() && !instance_filename.empty() && !scp_save( instance_filename, instance, level ) )
+	{
+		std::cerr << "Error writing '" << instance_filename << "'" << std::endl;
+		return 0;
+	}
+
+	// Renumber the instance for locality, the solutions being written with
+	// the original columns
+
+	if ( order != order_none )
+	{
+		double rows_before = 0, columns_before = 0, rows_after = 0, columns_after = 0, t = 0;
+		chrono::time_point begin;
+
+		if ( verbose ) scp_renumbering::spread( instance, rows_before, columns_before );
+
+		begin = chrono::now();
+		renumbering.build( instance, order );
+		renumbering.apply( instance );
+		t = chrono::now() - begin;
+
+		driver.columns = &renumbering.columns;
+
+		if ( verbose )
+		{
+			scp_renumbering::spread( instance, rows_after, columns_after );
+			std::cout << "Renumbering: " << scp_order_name( order ) << " | time = " << t << " s"
+			          << " | row spread = " << 100. * rows_before << "% -> " << 100. * rows_after << "%"
+			          << " | column spread = " << 100. * columns_before << "% -> " << 100. * columns_after << "%" << std::endl;
+		}
+	}
+
 	// Load the instance in algorithms
 
-	cplex.read( instance );
-	grasp.read( instance );
-	local_search.read( instance );
+	if ( !island.joined() )
+	{
+		index.build( instance );
+		driver.read( instance, index );
 
-	// Compute an optimal solution using CPLEX solver
+		if ( verbose )
+		{
+			std::cout << "Memory: instance = " << instance.memory() / 1048576. << " MB"
+			          << " | index = " << index.memory() / 1048576. << " MB"
+			          << " | solvers = " << driver.memory() / 1048576. << " MB" << std::endl;
 
-	if ( !cplex.run() )
+			if ( scp_memory::pages() != scp_memory::normal )
+			{
+				scp_memory::write( std::cout );
+			}
+		}
+	}
+
+	if ( island.joined() )
 	{
-		std::cerr << "Error: CPLEX fail" << std::endl;
-		return 0;
+		// Reference computed by the creator of the island
 	}
+	else if ( bound_str == "lagrangian" )
+	{
+		// Bound of the linear relaxation without CPLEX
 
-	z_opt = cplex.z();
+		chrono::time_point begin = chrono::now();
 
-	// Display the results
+		lp.epsilon = driver.epsilon;
+		lp.read( instance, index );
 
-	if ( verbose )
+		if ( !lp.run() )
+		{
+			std::cerr << "Error: infeasible instance" << std::endl;
+			return 0;
+		}
+
+		driver.z_ref = lp.z();
+
+		if ( verbose )
+		{
+			std::cout << "[*] Lagrangian: " << lp.z() << " | upper = " << lp.z_upper()
+			          << " | iterations = " << lp.iterations()
+			          << " | time = " << chrono::now() - begin << " s" << std::endl;
+		}
+	}
+	else if ( bound_str == "lp" )
 	{
-		std::cout << "[*] CPLEX: " << z_opt << std::endl;
+		// Linear relaxation using CPLEX solver, whose duals give the
+		// reduced costs
+
+		cplex.read( instance, true );
+
+		if ( !cplex.run() )
+		{
+			std::cerr << "Error: CPLEX fail" << std::endl;
+			return 0;
+		}
+
+		lp.epsilon = driver.epsilon;
+		lp.read( instance, index );
+		lp.read( cplex.duals() );
+
+		driver.z_ref = cplex.z();
+
+		if ( verbose )
+		{
+			std::cout << "[*] CPLEX LP: " << driver.z_ref << std::endl;
+		}
 	}
+	else if ( target == -std::numeric_limits<double>::infinity() )
+	{
+		// Compute an optimal solution using CPLEX solver
 
-	// Run the metaheuristics
+		cplex.read( instance );
 
-	begin = chrono::now();
+		if ( !cplex.run() )
+		{
+			std::cerr << "Error: CPLEX fail" << std::endl;
+			return 0;
+		}
 
-	try
+		driver.z_ref = cplex.z();
+
+		// Display the results
+
+		if ( verbose )
+		{
+			std::cout << "[*] CPLEX: " << driver.z_ref << std::endl;
+		}
+	}
+
+	// The target value, if any, is the reference to compute gaps
+
+	if ( !island.joined() && target > -std::numeric_limits<double>::infinity() )
+	{
+		driver.z_ref = target;
+
+		if ( verbose )
+		{
+			std::cout << "[*] Target: " << driver.z_ref << " (reference of the gaps)" << std::endl;
+		}
+	}
+
+	// Remove the columns which belong to no solution better than the upper
+	// bound from the rows, their numbers being kept, and score the columns
+	// by reduced cost
+
+	if ( fix || score_str == "dual" )
 	{
-		for ( int k = 0; k < num_runs; ++k )
+		if ( fix )
 		{
-			double z_g = 0, z_ls = 0, gap = 0;
-			std::set<int> x;
+			std::vector<bool> fixed;
+			int count = lp.fix( lp.z_upper(), fixed );
 
-			// Generate a solution using GRASP
+			for ( int j = 0; j < instance.num_sets(); ++j )
+			{
+				std::vector<int> & s = instance.S[j];
+				std::size_t q = 0;
+
+				for ( std::size_t p = 0; p < s.size(); ++p )
+				{
+					if ( !fixed[s[p]] ) s[q++] = s[p];
+				}
+				s.resize( q );
+			}
+			index.build( instance );
 
-			if ( !grasp.run() )
+			if ( verbose )
 			{
-				throw std::runtime_error( "GRASP fail" );
+				std::cout << "Fixing: " << count << " of " << instance.num_elements()
+				          << " columns removed, with a reduced cost above " << lp.z_upper() - lp.z() << std::endl;
 			}
+		}
 
-			x = grasp.x();
-			z_g = grasp.z();
+		// The columns of negative reduced cost, those of the Lagrangian
+		// solution, are all scored as free
+		if ( score_str == "dual" )
+		{
+			weights = lp.reduced_costs();
 
-			if ( !instance.check( x, z_g ) )
+			for ( std::size_t i = 0; i < weights.size(); ++i )
 			{
-				throw std::runtime_error( "GRASP check fail" );
+				weights[i] = std::max( weights[i], 0. );
 			}
+			driver.weights = &weights;
+		}
+		driver.read( instance, index );
+	}
+
+	if ( !island_name.empty() && !island.joined() && !island.publish( instance, index, driver.z_ref, filename ) )
+	{
+		std::cerr << "Error: cannot publish island '" << island_name << "'" << std::endl;
+		return 0;
+	}
 
-			local_search.read( x );
+	// Initialize stopping criteria
 
-			// Find a better solution using a local search
+	driver.stop.max_iterations = num_runs;
+	driver.stop.stall_iterations = stall_iterations;
+	driver.stop.time_limit = time_limit;
+	driver.stop.target = target;
+
+	// Run the metaheuristics
+
+	driver.start();
+
+	try
+	{
+		if ( num_threads > 1 )
+		{
+			parallel.numa = numa;
+			parallel.run( driver, num_threads, seed, &island, migration );
+		}
 
-			if ( !local_search.run() )
+		while ( num_threads <= 1 && !driver.done() )
+		{
+			driver.iterate();
+
+			if ( island.joined() && migration > 0 && driver.iterations() % migration == 0 )
 			{
-				throw std::runtime_error( "Local search fail" );
+				island.exchange( driver );
 			}
+		}
+	}
+	catch ( std::exception & e )
+	{
+		std::cerr << "Error: " << e.what() << std::endl;
+	}
 
-			x = local_search.x();
-			z_ls = local_search.z();
+	total_time = driver.stop.elapsed();
+	num_iterations = driver.iterations();
 
-			if ( !instance.check( x, z_ls ) )
+	if ( num_iterations == 0 )
+	{
+		std::cerr << "Error: no iteration completed" << std::endl;
+		return 0;
+	}
+
+	// Write the best solution
+
+	if ( !solution_filename.empty() )
+	{
+		scp_ofstream file;
+
+		if ( !file.open( solution_filename, level ) )
+		{
+			std::cerr << "Error opening '" << solution_filename << "'" << std::endl;
+		}
+		else
+		{
+			scp_write_solution( file, driver.z(), driver.x(), driver.columns );
+
+			if ( !file.close() )
 			{
-				throw std::runtime_error( "Local search check fail" );
+				std::cerr << "Error writing '" << solution_filename << "'" << std::endl;
 			}
+		}
+	}
 
-			gap = ( z_ls - z_opt ) / z_opt;
+	// Write the statistics of Reactive GRASP, whatever the verbosity
 
-			if ( gap < min_gap ) min_gap = gap;
-			if ( gap > max_gap ) max_gap = gap;
-			sum_gap += gap;
+	if ( !stats_filename.empty() )
+	{
+		scp_ofstream file;
 
-			// Display the results
+		if ( !file.open( stats_filename, level ) )
+		{
+			std::cerr << "Error opening '" << stats_filename << "'" << std::endl;
+		}
+		else
+		{
+			driver.reactive_alpha.write_table( file );
 
-			if ( verbose )
+			if ( !file.close() )
 			{
-				std::cout << "[" << k+1 << "] GRASP: " << z_g
-				          << " | GRASP+LS: " << z_ls
-				          << " | gap = " << 100. * gap << "%" << std::endl;
+				std::cerr << "Error writing '" << stats_filename << "'" << std::endl;
 			}
 		}
 	}
-	catch ( std::exception & e )
+
+	if ( !pool_file.close() )
 	{
-		std::cerr << "Error: " << e.what() << std::endl;
+		std::cerr << "Error writing '" << pool_filename << "'" << std::endl;
 	}
 
-	end = chrono::now();
+	if ( !incumbents_file.close() )
+	{
+		std::cerr << "Error writing '" << incumbents_filename << "'" << std::endl;
+	}
 
 	// Display result
 
 	if ( verbose )
 	{
-		std::cout << "Gap: min = " << 100. * min_gap << "%"
-			  << " | avg = " << 100. * sum_gap / double( num_runs ) << "%"
-			  << " | max = " << 100. * max_gap << "%" << std::endl;
+		std::cout << "Gap: min = " << 100. * driver.min_gap() << "%"
+			  << " | avg = " << 100. * driver.avg_gap() << "%"
+			  << " | max = " << 100. * driver.max_gap() << "%" << std::endl;
+
+		std::cout << "Time: avg = " << 1000. * total_time / double( num_iterations ) << " ms"
+			  << " | total = " << total_time << " s" << std::endl;
 
-		std::cout << "Time: avg = " << 1000. * ( end - begin ) / double( num_runs ) << " ms" << std::endl;
+		std::cout << "Best: " << driver.z()
+			  << " | iterations = " << num_iterations << std::endl;
+
+
+		if ( num_threads > 1 )
+		{
+			std::cout << "Threads: " << num_threads << " | steals = " << parallel.steals() << std::endl;
+
+			if ( numa )
+			{
+				parallel.write_numa( std::cout );
+			}
+		}
+
+		if ( driver.stop.target_reached() )
+		{
+			std::cout << "Target: reached in " << driver.stop.time_to_target() << " s"
+				  << " (" << driver.stop.iterations_to_target() << " iterations)" << std::endl;
+		}
+		else if ( target > -std::numeric_limits<double>::infinity() )
+		{
+			std::cout << "Target: not reached" << std::endl;
+		}
+
+		if ( reactive )
+		{
+			std::cout << "Reactive GRASP:" << std::endl;
+			driver.reactive_alpha.write( std::cout );
+		}
 	}
 	else
 	{
+		std::cout.precision( scp_precision );
 		std::cout
-			<< 100. * min_gap << " "
-			<< 100. * sum_gap / double( num_runs ) << " "
-			<< 100. * max_gap << " "
-			<< 1000. * ( end - begin ) / double( num_runs ) << std::endl;
+			<< 100. * driver.min_gap() << " "
+			<< 100. * driver.avg_gap() << " "
+			<< 100. * driver.max_gap() << " "
+			<< 1000. * total_time / double( num_iterations ) << " "
+			<< driver.z() << " "
+			<< num_iterations << " "
+			<< ( driver.stop.target_reached() ? driver.stop.time_to_target() : -1 ) << std::endl;
 	}
 
+#ifdef SCP_PROFILE
+	scp_profile::write( std::clog );
+#endif
+
 	return 0;
 }
@@ -0,0 +1,442 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "scp_batch.hpp"
+#include "scp_solver_cplex.hpp"
+#include <sstream>
+#include <map>
+#include <limits>
+#include <stdexcept>
+
+scp_batch_job::scp_batch_job() :
+	id( 0 ),
+	format( format_scp ),
+	alpha( 0.9 ),
+	epsilon( 1e-9 ),
+	time_limit( 0 ),
+	target( -std::numeric_limits<double>::infinity() ),
+	num_runs( 100 ),
+	stall_iterations( 0 ),
+	block( 20 ),
+	verify( 0 ),
+	seed( 0 ),
+	reactive( false ),
+	alphas( "0.1,0.2,0.3,0.4,0.5,0.6,0.7,0.8,0.9,1" )
+{
+}
+
+// Set a parameter from its manifest name
+bool scp_batch_job::set( const std::string & key, const std::string & value )
+{
+	std::istringstream vs( value );
+	int flag = 0;
+
+	if ( key == "format" )           return scp_format_parse( value, format );
+	if ( key == "alpha" )            return vs >> alpha && alpha >= 0 && alpha <= 1;
+	if ( key == "epsilon" )          return vs >> epsilon;
+	if ( key == "n" )                return vs >> num_runs;
+	if ( key == "seed" )             return vs >> seed;
+	if ( key == "target" )           return vs >> target;
+	if ( key == "time-limit" )       return vs >> time_limit;
+	if ( key == "stall-iterations" ) return vs >> stall_iterations;
+	if ( key == "block" )            return vs >> block;
+	if ( key == "verify" )           return vs >> verify;
+
+	if ( key == "alphas" )
+	{
+		alphas = value;
+		return true;
+	}
+
+	if ( key == "reactive" && vs >> flag )
+	{
+		reactive = ( flag != 0 );
+		return true;
+	}
+	return false;
+}
+
+// Whether at least one stopping criterion is set
+bool scp_batch_job::stopping() const
+{
+	return num_runs > 0 || time_limit > 0 || stall_iterations > 0
+	    || target > -std::numeric_limits<double>::infinity();
+}
+
+// Set the parameters of a driver, throws std::runtime_error if invalid
+void scp_batch_job::apply( scp_driver & driver ) const
+{
+	driver.alpha = alpha;
+	driver.epsilon = epsilon;
+	driver.reactive = reactive;
+	driver.verify = verify;
+	driver.reactive_alpha.block = block;
+	driver.reactive_alpha.read( reactive ? alphas : "" );
+
+	driver.stop.max_iterations = num_runs;
+	driver.stop.stall_iterations = stall_iterations;
+	driver.stop.time_limit = time_limit;
+	driver.stop.target = target;
+
+	if ( reactive && driver.reactive_alpha.size() == 0 )
+	{
+		throw std::runtime_error( "no valid alpha value" );
+	}
+}
+
+scp_batch::scp_batch() :
+	_resident( 0 ), _max_resident( 1 ), _loaded( false ), _os( 0 )
+{
+	pthread_mutex_init( &_mutex, 0 );
+	pthread_cond_init( &_cond_ready, 0 );
+	pthread_cond_init( &_cond_loader, 0 );
+}
+
+scp_batch::~scp_batch()
+{
+	for ( std::size_t k = 0; k < _slots.size(); ++k )
+	{
+		delete _slots[k].index;
+		delete _slots[k].instance;
+	}
+
+	pthread_cond_destroy( &_cond_loader );
+	pthread_cond_destroy( &_cond_ready );
+	pthread_mutex_destroy( &_mutex );
+}
+
+bool scp_batch::read( std::istream & is, const scp_batch_job & defaults )
+{
+	std::map<std::string, int> slot_index;
+	std::string line;
+	int line_number = 0;
+
+	while ( std::getline( is, line ) )
+	{
+		std::istringstream iss( line );
+		scp_batch_job job = defaults;
+		unsigned int seed_first = job.seed, seed_last = job.seed;
+		std::string token, key;
+
+		++line_number;
+
+		if ( !( iss >> job.filename ) || job.filename[0] == '#' )
+		{
+			continue;
+		}
+
+		while ( iss >> token )
+		{
+			std::string::size_type eq = token.find( '=' );
+			std::string value = eq != std::string::npos ? token.substr( eq + 1 ) : "";
+			std::istringstream vs( value );
+			bool ok = eq != std::string::npos;
+			char dash = 0;
+
+			key = token.substr( 0, eq );
+
+			if ( ok && key == "seed" )
+			{
+				ok = vs >> seed_first;
+				seed_last = seed_first;
+
+				if ( ok && vs >> dash )
+				{
+					ok = dash == '-' && vs >> seed_last && seed_first <= seed_last;
+				}
+			}
+			else if ( ok )
+			{
+				ok = job.set( key, value );
+			}
+
+			if ( !ok )
+			{
+				std::cerr << "Error: line " << line_number << ": invalid parameter '" << token << "'" << std::endl;
+				return false;
+			}
+		}
+
+		if ( !job.stopping() )
+		{
+			std::cerr << "Error: line " << line_number << ": no stopping criterion" << std::endl;
+			return false;
+		}
+
+		// Jobs on the same instance share a slot
+		key = job.filename + '\n' + scp_format_name( job.format );
+
+		if ( slot_index.find( key ) == slot_index.end() )
+		{
+			slot s;
+
+			s.filename = job.filename;
+			s.format = job.format;
+			s.instance = 0;
+			s.index = 0;
+			s.remaining = 0;
+			s.z_ref = 0;
+			s.failed = false;
+			s.cplex_failed = false;
+
+			slot_index[key] = _slots.size();
+			_slots.push_back( s );
+		}
+
+		for ( unsigned int seed = seed_first; ; ++seed )
+		{
+			slot & s = _slots[slot_index[key]];
+
+			job.id = _jobs.size() + 1;
+			job.seed = seed;
+
+			s.jobs.push_back( _jobs.size() );
+			++s.remaining;
+
+			_job_slot.push_back( slot_index[key] );
+			_jobs.push_back( job );
+
+			if ( seed == seed_last ) break;
+		}
+	}
+	return true;
+}
+
+void scp_batch::run( int num_threads, std::ostream & os )
+{
+	std::vector<pthread_t> workers( num_threads > 0 ? num_threads : 1 );
+	pthread_t loader;
+
+	_os = &os;
+	_loaded = false;
+	_resident = 0;
+
+	// Load one instance ahead of the workers
+	_max_resident = workers.size() + 1;
+
+	pthread_create( &loader, 0, _loader, this );
+
+	for ( std::size_t k = 0; k < workers.size(); ++k )
+	{
+		pthread_create( &workers[k], 0, _worker, this );
+	}
+
+	pthread_join( loader, 0 );
+
+	for ( std::size_t k = 0; k < workers.size(); ++k )
+	{
+		pthread_join( workers[k], 0 );
+	}
+}
+
+int scp_batch::size() const
+{
+	return _jobs.size();
+}
+
+void * scp_batch::_loader( void * self )
+{
+	static_cast<scp_batch *>( self )->_load();
+	return 0;
+}
+
+void * scp_batch::_worker( void * self )
+{
+	static_cast<scp_batch *>( self )->_work();
+	return 0;
+}
+
+void scp_batch::_load()
+{
+	scp_solver_cplex * cplex = 0;
+
+	for ( std::size_t k = 0; k < _slots.size(); ++k )
+	{
+		slot & s = _slots[k];
+		scp_problem * instance = new scp_problem();
+		scp_index * index = 0;
+		double z_ref = 0;
+		bool cplex_failed = false, reference = false;
+
+		pthread_mutex_lock( &_mutex );
+		while ( _resident >= _max_resident )
+		{
+			pthread_cond_wait( &_cond_loader, &_mutex );
+		}
+		++_resident;
+		pthread_mutex_unlock( &_mutex );
+
+		// Read and index the instance while the workers are solving
+		if ( scp_load( s.filename, s.format, *instance ) )
+		{
+			index = new scp_index( *instance );
+		}
+		else
+		{
+			delete instance;
+			instance = 0;
+		}
+
+		// Reference value of the jobs without target, computed once for
+		// all of them
+		for ( std::size_t p = 0; p < s.jobs.size(); ++p )
+		{
+			reference = reference || _jobs[s.jobs[p]].target == -std::numeric_limits<double>::infinity();
+		}
+
+		if ( instance && reference )
+		{
+			try
+			{
+				// The CPLEX environment is created once
+				if ( !cplex )
+				{
+					cplex = new scp_solver_cplex();
+				}
+
+				cplex->read( *instance );
+
+				cplex_failed = !cplex->run();
+				z_ref = cplex_failed ? 0 : cplex->z();
+			}
+			catch ( std::exception & )
+			{
+				cplex_failed = true;
+			}
+		}
+
+		pthread_mutex_lock( &_mutex );
+		s.instance = instance;
+		s.index = index;
+		s.z_ref = z_ref;
+		s.failed = ( instance == 0 );
+		s.cplex_failed = cplex_failed;
+		_ready.insert( _ready.end(), s.jobs.begin(), s.jobs.end() );
+		pthread_cond_broadcast( &_cond_ready );
+		pthread_mutex_unlock( &_mutex );
+	}
+
+	pthread_mutex_lock( &_mutex );
+	_loaded = true;
+	pthread_cond_broadcast( &_cond_ready );
+	pthread_mutex_unlock( &_mutex );
+
+	delete cplex;
+}
+
+void scp_batch::_work()
+{
+	scp_driver driver;
+	int k;
+
+	while ( _pop( k ) )
+	{
+		const scp_batch_job & job = _jobs[k];
+		const slot & s = _slots[_job_slot[k]];
+		std::ostringstream result;
+
+		result.precision( scp_precision );
+		result << "job=" << job.id
+		       << " file=" << job.filename
+		       << " seed=" << job.seed;
+
+		if ( s.failed )
+		{
+			result << " error=\"cannot read file\"";
+			_finish( k, result.str() );
+			continue;
+		}
+
+		try
+		{
+			job.apply( driver );
+
+			if ( job.target > -std::numeric_limits<double>::infinity() )
+			{
+				driver.z_ref = job.target;
+			}
+			else if ( s.cplex_failed )
+			{
+				throw std::runtime_error( "CPLEX fail" );
+			}
+			else
+			{
+				driver.z_ref = s.z_ref;
+			}
+
+			driver.read( *s.instance, *s.index );
+			driver.seed( job.seed );
+			driver.run();
+
+			result << " best=" << driver.z()
+			       << " iterations=" << driver.iterations()
+			       << " time=" << driver.elapsed()
+			       << " ttt=" << ( driver.stop.target_reached() ? driver.stop.time_to_target() : -1 )
+			       << " gap_min=" << 100. * driver.min_gap()
+			       << " gap_avg=" << 100. * driver.avg_gap()
+			       << " gap_max=" << 100. * driver.max_gap();
+		}
+		catch ( std::exception & e )
+		{
+			result << " error=\"" << e.what() << "\"";
+		}
+
+		_finish( k, result.str() );
+	}
+}
+
+bool scp_batch::_pop( int & job )
+{
+	bool ok = false;
+
+	pthread_mutex_lock( &_mutex );
+
+	while ( _ready.empty() && !_loaded )
+	{
+		pthread_cond_wait( &_cond_ready, &_mutex );
+	}
+
+	if ( !_ready.empty() )
+	{
+		job = _ready.front();
+		_ready.pop_front();
+		ok = true;
+	}
+
+	pthread_mutex_unlock( &_mutex );
+	return ok;
+}
+
+void scp_batch::_finish( int job, const std::string & result )
+{
+	slot & s = _slots[_job_slot[job]];
+
+	pthread_mutex_lock( &_mutex );
+
+	*_os << result << std::endl;
+
+	// Release the instance after its last job
+	if ( --s.remaining == 0 )
+	{
+		delete s.index;
+		delete s.instance;
+		s.index = 0;
+		s.instance = 0;
+		--_resident;
+		pthread_cond_signal( &_cond_loader );
+	}
+
+	pthread_mutex_unlock( &_mutex );
+}
@@ -0,0 +1,295 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "scp_parallel.hpp"
+#include <limits>
+#include <stdexcept>
+
+scp_parallel::scp_parallel() :
+	numa( false ), _driver( 0 ), _seed( 0 ), _island( 0 ), _migration( 0 )
+{
+	pthread_mutex_init( &_mutex, 0 );
+}
+
+scp_parallel::~scp_parallel()
+{
+	_clear();
+	pthread_mutex_destroy( &_mutex );
+}
+
+// Run the tries of a started driver until its stopping criteria are met,
+// throws std::runtime_error on failure
+void scp_parallel::run( scp_driver & driver, int num_threads, unsigned int seed,
+                        scp_island * island, int migration )
+{
+	std::vector<pthread_t> threads( num_threads > 0 ? num_threads : 1 );
+	std::vector<task> tasks( threads.size() );
+	cpu_set_t affinity;
+
+	_clear();
+
+	_driver = &driver;
+	_seed = seed;
+	_island = island;
+	_migration = migration;
+	_error.clear();
+
+	// The calling thread runs the first worker, and is pinned in NUMA mode
+	pthread_getaffinity_np( pthread_self(), sizeof( affinity ), &affinity );
+
+	if ( numa )
+	{
+		_replicate( threads.size() );
+	}
+
+	_workers.assign( threads.size(), (scp_driver *) 0 );
+	_scheduler.start( threads.size(), driver.stop.max_iterations );
+
+	for ( std::size_t w = 0; w < threads.size(); ++w )
+	{
+		tasks[w].self = this;
+		tasks[w].worker = w;
+	}
+
+	for ( std::size_t w = 1; w < threads.size(); ++w )
+	{
+		pthread_create( &threads[w], 0, _worker, &tasks[w] );
+	}
+
+	_work( 0 );
+
+	for ( std::size_t w = 1; w < threads.size(); ++w )
+	{
+		pthread_join( threads[w], 0 );
+	}
+
+	pthread_setaffinity_np( pthread_self(), sizeof( affinity ), &affinity );
+
+	if ( driver.reactive )
+	{
+		for ( std::size_t w = 0; w < _workers.size(); ++w )
+		{
+			if ( _workers[w] ) driver.reactive_alpha.merge( _workers[w]->reactive_alpha );
+		}
+	}
+
+	if ( !_error.empty() )
+	{
+		throw std::runtime_error( _error );
+	}
+}
+
+// Number of ranges of tries stolen by idle threads during the last run
+int scp_parallel::steals() const
+{
+	return _scheduler.steals();
+}
+
+// Threads and index of each node used by the last run in NUMA mode, with
+// the share of the index pages found on the node
+void scp_parallel::write_numa( std::ostream & os ) const
+{
+	for ( std::size_t k = 0; k < _replicas.size(); ++k )
+	{
+		const scp_index & index = _replicas[k] ? *_replicas[k] : _driver->index();
+		std::vector<int> count;
+		int threads = 0, local = 0, total = 0;
+
+		for ( std::size_t w = 0; w < _workers.size(); ++w )
+		{
+			if ( _topology.worker_node( w ) == int( k ) ) ++threads;
+		}
+
+		_pages( index, count );
+
+		for ( std::size_t node = 0; node < count.size(); ++node )
+		{
+			total += count[node];
+			if ( int( node ) == _topology.node( k ) ) local += count[node];
+		}
+
+		os << "Node " << _topology.node( k ) << ": threads = " << threads
+		   << " | index = " << index.memory() / 1048576. << " MB"
+		   << ( _replicas[k] ? " (replica)" : " (shared)" )
+		   << " | local pages = ";
+
+		if ( total > 0 )
+		{
+			os << 100. * local / total << "%" << std::endl;
+		}
+		else
+		{
+			os << "unknown" << std::endl;
+		}
+	}
+}
+
+void * scp_parallel::_worker( void * t )
+{
+	const task & self = *static_cast<task *>( t );
+	self.self->_work( self.worker );
+	return 0;
+}
+
+void scp_parallel::_work( int worker )
+{
+	bool locked = false;
+	int k = 0;
+
+	try
+	{
+		// The copy is allocated and filled by this thread, so on its node,
+		// under the lock since the other workers may be merging into the
+		// original. It only stops on time, the other criteria being
+		// evaluated on all the tries by the original
+		if ( numa )
+		{
+			scp_numa::pin( _topology.worker_cpu( worker ) );
+		}
+
+		pthread_mutex_lock( &_mutex );
+		locked = true;
+
+		_workers[worker] = new scp_driver( *_driver );
+
+		locked = false;
+		pthread_mutex_unlock( &_mutex );
+
+		scp_driver & driver = *_workers[worker];
+
+		if ( numa && _replicas[_topology.worker_node( worker )] )
+		{
+			driver.read( _driver->instance(), *_replicas[_topology.worker_node( worker )] );
+		}
+
+		driver.log = 0;
+		driver.incumbents = 0;
+		driver.pool = 0;
+		driver.stop.max_iterations = 0;
+		driver.stop.stall_iterations = 0;
+		driver.stop.target = -std::numeric_limits<double>::infinity();
+		driver.start();
+
+		while ( _scheduler.next( worker, k ) )
+		{
+			driver.seed( _mix( _mix( _seed ) + k ) );
+			driver.iterate();
+
+			pthread_mutex_lock( &_mutex );
+			locked = true;
+
+			_driver->merge( driver );
+
+			if ( _island && _island->joined() && _migration > 0 && _driver->iterations() % _migration == 0 )
+			{
+				_island->exchange( *_driver );
+			}
+
+			if ( _driver->done() )
+			{
+				_scheduler.stop();
+			}
+
+			locked = false;
+			pthread_mutex_unlock( &_mutex );
+		}
+	}
+	catch ( std::exception & e )
+	{
+		if ( !locked ) pthread_mutex_lock( &_mutex );
+
+		if ( _error.empty() ) _error = e.what();
+		_scheduler.stop();
+
+		pthread_mutex_unlock( &_mutex );
+	}
+}
+
+// Copy the index on each node with workers, unless most of its pages are
+// already there, by the calling thread pinned to the node
+void scp_parallel::_replicate( int num_threads )
+{
+	const scp_index & index = _driver->index();
+	std::vector<int> count;
+	int home = -1, most = 0, num_nodes = _topology.num_nodes();
+
+	_pages( index, count );
+
+	for ( std::size_t node = 0; node < count.size(); ++node )
+	{
+		if ( count[node] > most )
+		{
+			home = node;
+			most = count[node];
+		}
+	}
+
+	_replicas.assign( num_nodes, (scp_index *) 0 );
+
+	for ( int k = 0; k < num_nodes && k < num_threads; ++k )
+	{
+		if ( _topology.node( k ) == home || num_nodes == 1 ) continue;
+
+		// A plain copy of an attached index would read the same buffer
+		scp_numa::pin( _topology.cpus( k ) );
+		_replicas[k] = new scp_index();
+		_replicas[k]->copy( index );
+	}
+}
+
+void scp_parallel::_clear()
+{
+	for ( std::size_t w = 0; w < _workers.size(); ++w )
+	{
+		delete _workers[w];
+	}
+	_workers.clear();
+
+	for ( std::size_t k = 0; k < _replicas.size(); ++k )
+	{
+		delete _replicas[k];
+	}
+	_replicas.clear();
+}
+
+// Pages of the index on each node, its bulk being the elements of the sets
+// and the sets of the elements
+void scp_parallel::_pages( const scp_index & index, std::vector<int> & count )
+{
+	int m = index.num_elements(),
+	    n = index.num_sets();
+
+	if ( m == 0 || n == 0 ) return;
+
+	scp_numa::pages( index.S_begin( 0 ), ( index.S_end( n - 1 ) - index.S_begin( 0 ) ) * sizeof( int ), count );
+
+	if ( index.compact() )
+	{
+		scp_numa::pages( index.T_begin<uint16_t>( 0 ), ( index.T_end<uint16_t>( m - 1 ) - index.T_begin<uint16_t>( 0 ) ) * sizeof( uint16_t ), count );
+	}
+	else
+	{
+		scp_numa::pages( index.T_begin<int>( 0 ), ( index.T_end<int>( m - 1 ) - index.T_begin<int>( 0 ) ) * sizeof( int ), count );
+	}
+}
+
+// Seed of a try, well spread even for consecutive values (SplitMix64)
+uint64_t scp_parallel::_mix( uint64_t s )
+{
+	s += UINT64_C( 0x9E3779B97F4A7C15 );
+	s = ( s ^ ( s >> 30 ) ) * UINT64_C( 0xBF58476D1CE4E5B9 );
+	s = ( s ^ ( s >> 27 ) ) * UINT64_C( 0x94D049BB133111EB );
+	return s ^ ( s >> 31 );
+}
@@ -0,0 +1,403 @@
+/* -*- c++ -*-
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "scp_server.hpp"
+#include "scp_driver.hpp"
+#include "fdstream.hpp"
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <limits>
+#include <stdexcept>
+#include <new>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+namespace
+{
+
+volatile std::sig_atomic_t interrupted = 0;
+
+extern "C" void interrupt( int )
+{
+	interrupted = 1;
+}
+
+// Read a header line like std::getline, but fail the stream on a line
+// longer than max_size, so that a client cannot grow it without bound
+std::istream & read_line( std::istream & is, std::string & line, std::size_t max_size )
+{
+	std::istream::int_type ch;
+
+	line.clear();
+
+	while ( ( ch = is.get() ) != std::istream::traits_type::eof() && ch != '\n' )
+	{
+		line += std::istream::traits_type::to_char_type( ch );
+
+		if ( line.size() > max_size )
+		{
+			is.setstate( std::ios::failbit );
+			return is;
+		}
+	}
+
+	// A last line without newline is read, as by std::getline
+	if ( ch == std::istream::traits_type::eof() && !line.empty() )
+	{
+		is.clear( std::ios::eofbit );
+	}
+	return is;
+}
+
+// Read an instance and check that it can be solved
+void read_instance( const scp_batch_job & job, const std::string & data, scp_problem & instance )
+{
+	std::istringstream is( data );
+
+	if ( !scp_read( job.format, is, instance ) )
+	{
+		throw std::runtime_error( "invalid instance" );
+	}
+
+	if ( !instance.check() )
+	{
+		throw std::runtime_error( "infeasible instance" );
+	}
+}
+
+}
+
+scp_server::scp_server() :
+	max_bytes( 1L << 30 ), max_line( 4096 ), timeout( 60 ), _socket( -1 ), _closing( false )
+{
+	pthread_mutex_init( &_mutex, 0 );
+	pthread_cond_init( &_cond, 0 );
+}
+
+scp_server::~scp_server()
+{
+	if ( _socket >= 0 )
+	{
+		::close( _socket );
+		::unlink( _path.c_str() );
+	}
+
+	pthread_cond_destroy( &_cond );
+	pthread_mutex_destroy( &_mutex );
+}
+
+bool scp_server::listen( const std::string & path )
+{
+	struct sockaddr_un address;
+
+	if ( path.size() >= sizeof( address.sun_path ) )
+	{
+		std::cerr << "Error: socket path too long '" << path << "'" << std::endl;
+		return false;
+	}
+
+	std::memset( &address, 0, sizeof( address ) );
+	address.sun_family = AF_UNIX;
+	std::strcpy( address.sun_path, path.c_str() );
+
+	if ( ( _socket = ::socket( AF_UNIX, SOCK_STREAM, 0 ) ) < 0 )
+	{
+		std::cerr << "Error: socket: " << std::strerror( errno ) << std::endl;
+		return false;
+	}
+
+	// Remove the socket file left by a previous server
+	::unlink( path.c_str() );
+
+	if ( ::bind( _socket, reinterpret_cast<struct sockaddr *>( &address ), sizeof( address ) ) < 0
+	  || ::listen( _socket, SOMAXCONN ) < 0 )
+	{
+		std::cerr << "Error: cannot listen on '" << path << "': " << std::strerror( errno ) << std::endl;
+		::close( _socket );
+		_socket = -1;
+		return false;
+	}
+
+	_path = path;
+	return true;
+}
+
+// Accept connections until SIGINT or SIGTERM
+void scp_server::run( int num_threads, const scp_batch_job & defaults )
+{
+	std::vector<pthread_t> workers( num_threads > 0 ? num_threads : 1 );
+	struct sigaction action;
+	sigset_t signals, old_signals;
+
+	_defaults = defaults;
+	_closing = false;
+	interrupted = 0;
+
+	std::memset( &action, 0, sizeof( action ) );
+	action.sa_handler = interrupt;
+	sigemptyset( &action.sa_mask );
+
+	// No SA_RESTART, so that accept() returns on a signal
+	sigaction( SIGINT, &action, 0 );
+	sigaction( SIGTERM, &action, 0 );
+	std::signal( SIGPIPE, SIG_IGN );
+
+	// The workers block the signals, which are handled by this thread
+	sigemptyset( &signals );
+	sigaddset( &signals, SIGINT );
+	sigaddset( &signals, SIGTERM );
+	pthread_sigmask( SIG_BLOCK, &signals, &old_signals );
+
+	for ( std::size_t k = 0; k < workers.size(); ++k )
+	{
+		pthread_create( &workers[k], 0, _worker, this );
+	}
+
+	pthread_sigmask( SIG_SETMASK, &old_signals, 0 );
+
+	while ( !interrupted )
+	{
+		int fd = ::accept( _socket, 0, 0 );
+
+		if ( fd < 0 )
+		{
+			if ( errno == EINTR || errno == ECONNABORTED ) continue;
+
+			std::cerr << "Error: accept: " << std::strerror( errno ) << std::endl;
+			break;
+		}
+
+		pthread_mutex_lock( &_mutex );
+		_connections.push_back( fd );
+		pthread_cond_signal( &_cond );
+		pthread_mutex_unlock( &_mutex );
+	}
+
+	// Close the pending and active connections, and wait for the workers
+	pthread_mutex_lock( &_mutex );
+	_closing = true;
+	while ( !_connections.empty() )
+	{
+		::close( _connections.front() );
+		_connections.pop_front();
+	}
+	for ( std::set<int>::iterator it = _active.begin(); it != _active.end(); ++it )
+	{
+		::shutdown( *it, SHUT_RDWR );
+	}
+	pthread_cond_broadcast( &_cond );
+	pthread_mutex_unlock( &_mutex );
+
+	for ( std::size_t k = 0; k < workers.size(); ++k )
+	{
+		pthread_join( workers[k], 0 );
+	}
+}
+
+void * scp_server::_worker( void * self )
+{
+	static_cast<scp_server *>( self )->_work();
+	return 0;
+}
+
+void scp_server::_work()
+{
+	scp_driver driver;
+	scp_problem instance;
+	fd::iostream stream;
+	std::string line, data;
+	int fd;
+
+	while ( _pop( fd ) )
+	{
+		stream.attach( fd );
+		stream.precision( scp_precision );
+
+		// A client that sends nothing for the timeout loses its connection,
+		// so that it cannot hold the worker
+		if ( timeout > 0 )
+		{
+			struct timeval tv;
+
+			tv.tv_sec = long( timeout );
+			tv.tv_usec = long( ( timeout - tv.tv_sec ) * 1e6 );
+			::setsockopt( fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof( tv ) );
+		}
+
+		while ( read_line( stream, line, max_line ) || line.size() > max_line )
+		{
+			// The stream, failed by the read, is cleared for the reply
+			if ( line.size() > max_line )
+			{
+				stream.clear();
+				stream << "ERROR header too long" << std::endl;
+				break;
+			}
+
+			std::istringstream iss( line );
+			scp_batch_job job = _defaults;
+			std::string command, token, error;
+			long bytes = -1;
+
+			if ( !( iss >> command ) )
+			{
+				continue;
+			}
+
+			if ( command == "QUIT" )
+			{
+				break;
+			}
+
+			if ( command == "PING" )
+			{
+				stream << "OK" << std::endl;
+				continue;
+			}
+
+			if ( command != "SOLVE" )
+			{
+				stream << "ERROR unknown command '" << command << "'" << std::endl;
+				continue;
+			}
+
+			while ( iss >> token )
+			{
+				std::string::size_type eq = token.find( '=' );
+				std::string key = token.substr( 0, eq ),
+				            value = eq != std::string::npos ? token.substr( eq + 1 ) : "";
+				bool ok = eq != std::string::npos;
+
+				if ( ok && key == "bytes" )
+				{
+					ok = std::istringstream( value ) >> bytes && bytes >= 0;
+				}
+				else if ( ok )
+				{
+					ok = job.set( key, value );
+				}
+
+				if ( !ok && error.empty() )
+				{
+					error = "invalid parameter '" + token + "'";
+				}
+			}
+
+			// Without the size, the next request cannot be found
+			if ( bytes < 0 )
+			{
+				stream << "ERROR missing bytes" << std::endl;
+				break;
+			}
+
+			if ( bytes > max_bytes )
+			{
+				stream << "ERROR request too large" << std::endl;
+				break;
+			}
+
+			try
+			{
+				data.resize( bytes );
+			}
+			catch ( std::bad_alloc & )
+			{
+				stream << "ERROR out of memory" << std::endl;
+				break;
+			}
+
+			if ( bytes > 0 && !stream.read( &data[0], bytes ) )
+			{
+				break;
+			}
+
+			if ( error.empty() && !job.stopping() )
+			{
+				error = "no stopping criterion";
+			}
+
+			if ( !error.empty() )
+			{
+				stream << "ERROR " << error << std::endl;
+				continue;
+			}
+
+			try
+			{
+				read_instance( job, data, instance );
+
+				job.apply( driver );
+				driver.read( instance );
+				driver.seed( job.seed );
+				driver.run();
+
+				const scp_solution & x = driver.x();
+				scp_solution::const_iterator it;
+
+				stream << "OK z=" << driver.z()
+				       << " iterations=" << driver.iterations()
+				       << " time=" << driver.elapsed()
+				       << " columns=" << x.size() << '\n';
+
+				for ( it = x.begin(); it != x.end(); ++it )
+				{
+					if ( it != x.begin() ) stream << ' ';
+					stream << *it+1;
+				}
+				stream << std::endl;
+			}
+			catch ( std::exception & e )
+			{
+				stream << "ERROR " << e.what() << std::endl;
+			}
+		}
+
+		pthread_mutex_lock( &_mutex );
+		_active.erase( fd );
+		pthread_mutex_unlock( &_mutex );
+
+		stream.attach( -1 );
+		::close( fd );
+	}
+}
+
+bool scp_server::_pop( int & fd )
+{
+	bool ok = false;
+
+	pthread_mutex_lock( &_mutex );
+
+	while ( _connections.empty() && !_closing )
+	{
+		pthread_cond_wait( &_cond, &_mutex );
+	}
+
+	if ( !_connections.empty() )
+	{
+		fd = _connections.front();
+		_connections.pop_front();
+		_active.insert( fd );
+		ok = true;
+	}
+
+	pthread_mutex_unlock( &_mutex );
+	return ok;
+}
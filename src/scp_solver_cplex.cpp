@@ -27,7 +27,8 @@ scp_solver_cplex::scp_solver_cplex() :
 	quiet();
 }
 
-void scp_solver_cplex::read( const scp_problem & instance )
+// With relaxed, the variables are continuous, in [0,1]
+void scp_solver_cplex::read( const scp_problem & instance, bool relaxed )
 {
 	int m = instance.num_elements(),
 	    n = instance.num_sets();
@@ -43,13 +44,13 @@ void scp_solver_cplex::read( const scp_problem & instance )
 
 		oss << "x(" << i+1 << ")";
 
-		_vars[i] = IloNumVar( _env, 0, 1, IloNumVar::Bool, oss.str().c_str() );
+		_vars[i] = IloNumVar( _env, 0, 1, relaxed ? IloNumVar::Float : IloNumVar::Bool, oss.str().c_str() );
 		_obj.setLinearCoef( _vars[i], instance.c[i] );
 	}
 
 	for ( int j = 0; j < n; ++j )
 	{
-		std::set<int>::const_iterator it;
+		std::vector<int>::const_iterator it;
 		std::ostringstream oss;
 
 		oss << "S(" << j+1 << ")";
@@ -84,24 +85,37 @@ double scp_solver_cplex::z() const
 	return _cpx.getObjValue();
 }
 
-std::set<int> scp_solver_cplex::x() const
+std::vector<int> scp_solver_cplex::x() const
 {
 	int m = _vars.getSize();
-	std::set<int> s;
+	std::vector<int> s;
 
 	for ( int i = 0; i < m; ++i )
 	{
 		if ( _cpx.getValue( _vars[i] ) > 0.5 )
 		{
-			s.insert( i );
+			s.push_back( i );
 		}
 	}
 	return s;
 }
 
-void scp_solver_cplex::cut( const std::set<int> & x )
+// Dual values of the rows, after solving the linear relaxation
+std::vector<double> scp_solver_cplex::duals() const
 {
-	std::set<int>::const_iterator it;
+	int n = _cons.getSize();
+	std::vector<double> u( n );
+
+	for ( int j = 0; j < n; ++j )
+	{
+		u[j] = _cpx.getDual( _cons[j] );
+	}
+	return u;
+}
+
+void scp_solver_cplex::cut( const std::vector<int> & x )
+{
+	std::vector<int>::const_iterator it;
 
 	IloRange cons( _env, -IloInfinity, x.size() - 1 );
 